@@ -14,41 +14,57 @@
  ***************************************************************************/
 #include "Arduino.h"
 #include "ADXL345.h"
-#include <Wire.h>
 
-#define DEVICE (0x53)    // ADXL345 device address
 #define TO_READ (6)      // num of bytes we are going to read each time (two bytes for each axis)
 
-ADXL345::ADXL345() {
+ADXL345::ADXL345(int32_t sensorID, uint8_t address) : Sensor(address, sensorID) {
+  i2c.setMaxClock(ADXL345_MAX_I2C_CLOCK);
   status = ADXL345_OK;
   error_code = ADXL345_NO_ERROR;
 
   gains[0] = 0.00376390;
   gains[1] = 0.00376009;
   gains[2] = 0.00349265;
+  memset(_buff, 0, sizeof(_buff));
 }
 
 void ADXL345::powerOn() {
-  Wire.begin();        // join i2c bus (address optional for master)
+  bus->begin();        // join i2c bus or set up the SPI chip select
   //Turning on the ADXL345
   writeTo(ADXL345_POWER_CTL, 0);      
   writeTo(ADXL345_POWER_CTL, 16);
   writeTo(ADXL345_POWER_CTL, 8); 
 }
 
-// Reads the acceleration into three variable x, y and z
-void ADXL345::readAccel(int *xyz){
-  readAccel(xyz, xyz + 1, xyz + 2);
+// Powers the device on, false if it doesn't answer with the ADXL345 id
+bool ADXL345::begin() {
+  byte id = 0;
+  powerOn();
+  readFrom(ADXL345_DEVID, 1, &id);
+  return id == ADXL345_ID;
 }
 
-void ADXL345::readAccel(int *x, int *y, int *z) {
-  readFrom(ADXL345_DATAX0, TO_READ, _buff); //read the acceleration data from the ADXL345
+// Reads the acceleration into three variable x, y and z
+uint8_t ADXL345::readAccel(int *xyz){
+  return readAccel(xyz, xyz + 1, xyz + 2);
+}
+
+// In new-data-only mode the last sample is returned again with
+// SENSOR_BUS_NO_DATA when DATA_READY is clear. Reading INT_SOURCE also
+// clears the latched tap, activity and free fall bits, so don't combine
+// this mode with ADXL345Events.
+uint8_t ADXL345::readAccel(int *x, int *y, int *z) {
+  uint8_t result = checkNewData(ADXL345_INT_SOURCE, 1 << ADXL345_INT_DATA_READY_BIT, 1 << ADXL345_INT_OVERRUNY_BIT);
+  if(result == SENSOR_BUS_OK){
+    readFrom(ADXL345_DATAX0, TO_READ, _buff); //read the acceleration data from the ADXL345
+  }
 
   // each axis reading comes in 10 bit resolution, ie 2 bytes.  Least Significat Byte first!!
   // thus we are converting both bytes in to one int
   *x = (((int)_buff[1]) << 8) | _buff[0];   
   *y = (((int)_buff[3]) << 8) | _buff[2];
   *z = (((int)_buff[5]) << 8) | _buff[4];
+  return result;
 }
 
 void ADXL345::get_Gxyz(double *xyz){
@@ -61,32 +77,16 @@ void ADXL345::get_Gxyz(double *xyz){
 }
 // Writes val to address register on device
 void ADXL345::writeTo(byte address, byte val) {
-  Wire.beginTransmission(DEVICE); // start transmission to device 
-  Wire.write(address);             // send register address
-  Wire.write(val);                 // send value to write
-  Wire.endTransmission();         // end transmission
+  bus->writeRegisters(address, &val, 1);
 }
 
 // Reads num bytes starting from address register on device in to _buff array
 void ADXL345::readFrom(byte address, int num, byte _buff[]) {
-  Wire.beginTransmission(DEVICE); // start transmission to device 
-  Wire.write(address);             // sends address to read from
-  Wire.endTransmission();         // end transmission
-
-  Wire.beginTransmission(DEVICE); // start transmission to device
-  Wire.requestFrom(DEVICE, num);    // request 6 bytes from device
-
-  int i = 0;
-  while(Wire.available())         // device may send less than requested (abnormal)
-  { 
-    _buff[i] = Wire.read();    // receive a byte
-    i++;
-  }
-  if(i != num){
+  // device may send less than requested (abnormal)
+  if(bus->readRegisters(address, _buff, num) != SENSOR_BUS_OK){
     status = ADXL345_ERROR;
     error_code = ADXL345_READ_ERROR;
   }
-  Wire.endTransmission();         // end transmission
 }
 
 // Gets the range setting and return it into rangeSetting
@@ -488,6 +488,30 @@ void ADXL345::setLowPower(bool state) {
   setRegisterBit(ADXL345_BW_RATE, 4, state); 
 }
 
+// Gets the state of the LINK bit
+bool ADXL345::getLinkBit(){
+  return getRegisterBit(ADXL345_POWER_CTL, 5);
+}
+
+// Sets the LINK bit
+// if set to 1 activity and inactivity are serially linked, so activity is only
+// looked for after inactivity has been detected and vice versa
+// if set to 0 both functions run concurrently
+void ADXL345::setLinkBit(bool state) {
+  setRegisterBit(ADXL345_POWER_CTL, 5, state);
+}
+
+bool ADXL345::isAutoSleep(){
+  return getRegisterBit(ADXL345_POWER_CTL, 4);
+}
+
+// Sets the AUTO_SLEEP bit
+// when set together with the LINK bit the device drops into sleep mode once
+// inactivity is detected and wakes again on activity
+void ADXL345::setAutoSleep(bool state) {
+  setRegisterBit(ADXL345_POWER_CTL, 4, state);
+}
+
 double ADXL345::getRate(){
   byte _b;
   readFrom(ADXL345_BW_RATE, 1, &_b);
@@ -532,6 +556,83 @@ byte ADXL345::getInterruptSource() {
   return _b;
 }
 
+// Selects a FIFO mode (ADXL345_FIFO_xxx); the watermark interrupt fires
+// once the FIFO holds more than watermark samples
+void ADXL345::setFifoMode(byte mode, byte watermark) {
+  writeTo(ADXL345_FIFO_CTL, mode | (watermark & 0x1F));
+}
+
+// Number of samples waiting, up to 33 as the data registers hold one
+// more than the FIFO
+byte ADXL345::getFifoEntries() {
+  byte _b;
+  readFrom(ADXL345_FIFO_STATUS, 1, &_b);
+  return _b & ADXL345_FIFO_ENTRIES;
+}
+
+// Pops count samples from the FIFO, oldest first. Each sample needs its
+// own 6 byte read of DATAX0..DATAZ1, the FIFO moves on when it ends.
+// At 3200Hz this is most of a 400kHz I2C bus, SPI is the better fit.
+uint8_t ADXL345::readFifo(int16_t (*xyz)[3], uint8_t count) {
+  for(uint8_t i = 0; i < count; i++){
+    uint8_t result = bus->readRegisters(ADXL345_DATAX0, _buff, TO_READ);
+    if(result != SENSOR_BUS_OK){
+      return result;
+    }
+    xyz[i][0] = (int16_t)((((int)_buff[1]) << 8) | _buff[0]);
+    xyz[i][1] = (int16_t)((((int)_buff[3]) << 8) | _buff[2]);
+    xyz[i][2] = (int16_t)((((int)_buff[5]) << 8) | _buff[4]);
+  }
+  return SENSOR_BUS_OK;
+}
+
+// Reads ACT_TAP_STATUS, INT_SOURCE and FIFO_STATUS in a single burst and decodes
+// them, so an interrupt can be dispatched with one bus access instead of a chain
+// of isTapSourceOnX()/isActivitySourceOnX()/isAsleep() calls.
+// Reading INT_SOURCE clears the latched interrupts, and the burst passes over the
+// data registers, so the current sample is returned in the snapshot as well.
+// Returns the bus status, the snapshot is left untouched unless it is
+// SENSOR_BUS_OK.
+uint8_t ADXL345::getSnapshot(ADXL345Snapshot* snapshot) {
+  byte _b[ADXL345_FIFO_STATUS - ADXL345_ACT_TAP_STATUS + 1];
+  uint8_t result = bus->readRegisters(ADXL345_ACT_TAP_STATUS, _b, sizeof(_b));
+  if(result != SENSOR_BUS_OK){
+    status = ADXL345_ERROR;
+    error_code = ADXL345_READ_ERROR;
+    return result;
+  }
+
+  byte actTap = _b[0];
+  byte source = _b[ADXL345_INT_SOURCE - ADXL345_ACT_TAP_STATUS];
+  byte fifo   = _b[ADXL345_FIFO_STATUS - ADXL345_ACT_TAP_STATUS];
+  byte *data  = _b + (ADXL345_DATAX0 - ADXL345_ACT_TAP_STATUS);
+
+  snapshot->dataReady   = (source >> ADXL345_INT_DATA_READY_BIT) & 1;
+  snapshot->singleTap   = (source >> ADXL345_INT_SINGLE_TAP_BIT) & 1;
+  snapshot->doubleTap   = (source >> ADXL345_INT_DOUBLE_TAP_BIT) & 1;
+  snapshot->activity    = (source >> ADXL345_INT_ACTIVITY_BIT) & 1;
+  snapshot->inactivity  = (source >> ADXL345_INT_INACTIVITY_BIT) & 1;
+  snapshot->freeFall    = (source >> ADXL345_INT_FREE_FALL_BIT) & 1;
+  snapshot->watermark   = (source >> ADXL345_INT_WATERMARK_BIT) & 1;
+  snapshot->overrun     = (source >> ADXL345_INT_OVERRUNY_BIT) & 1;
+
+  snapshot->activityX   = (actTap >> 6) & 1;
+  snapshot->activityY   = (actTap >> 5) & 1;
+  snapshot->activityZ   = (actTap >> 4) & 1;
+  snapshot->asleep      = (actTap >> 3) & 1;
+  snapshot->tapX        = (actTap >> 2) & 1;
+  snapshot->tapY        = (actTap >> 1) & 1;
+  snapshot->tapZ        = actTap & 1;
+
+  snapshot->fifoTrigger = (fifo >> 7) & 1;
+  snapshot->fifoEntries = fifo & 0x3F;
+
+  snapshot->x = (((int)data[1]) << 8) | data[0];
+  snapshot->y = (((int)data[3]) << 8) | data[2];
+  snapshot->z = (((int)data[5]) << 8) | data[4];
+  return SENSOR_BUS_OK;
+}
+
 bool ADXL345::getInterruptSource(byte interruptBit) {
   return getRegisterBit(ADXL345_INT_SOURCE,interruptBit);
 }
@@ -591,6 +692,45 @@ void ADXL345::printAllRegister() {
   }
 }
 
+// Provides the sensor_t data for this sensor
+void ADXL345::getSensor(sensor_t *sensor) {
+  /* Clear the sensor_t object */
+  memset(sensor, 0, sizeof(sensor_t));
+
+  /* Insert the sensor name in the fixed length char array */
+  strncpy (sensor->name, "ADXL345", sizeof(sensor->name) - 1);
+  sensor->name[sizeof(sensor->name)- 1] = 0;
+  sensor->version     = 1;
+  sensor->sensor_id   = deviceId;
+  sensor->type        = SENSOR_TYPE_ACCELEROMETER;
+  sensor->min_delay   = 0;
+  sensor->max_value   = 156.9064F;            // +/-16g = 156.9064 m/s^2
+  sensor->min_value   = -156.9064F;
+  sensor->resolution  = 0.03923F;             // 4mg = 0.0392266 m/s^2
+}
+
+// Reads the sensor and returns the data as a sensors_event_t in m/s^2,
+// returns the bus status
+uint8_t ADXL345::getEvent(sensors_event_t *event) {
+  double xyz[3];
+  uint32_t started = micros();
+
+  /* Clear the event */
+  memset(event, 0, sizeof(sensors_event_t));
+
+  event->version   = sizeof(sensors_event_t);
+  event->sensor_id = deviceId;
+  event->type      = SENSOR_TYPE_ACCELEROMETER;
+
+  bus->clearError();
+  get_Gxyz(xyz);
+  event->acceleration.x = xyz[0] * SENSORS_GRAVITY_STANDARD;
+  event->acceleration.y = xyz[1] * SENSORS_GRAVITY_STANDARD;
+  event->acceleration.z = xyz[2] * SENSORS_GRAVITY_STANDARD;
+  stampEvent(event, started);
+  return eventStatus();
+}
+
 void print_byte(byte val){
   int i;
   Serial.print("B");
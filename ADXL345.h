@@ -13,12 +13,19 @@
  *                                                                         *
  ***************************************************************************/
 #include "Arduino.h"
+#include "Sensor.h"
 
 #ifndef ADXL345_h
 #define ADXL345_h
 
+#define ADXL345_ADDRESS     0x53 // SDO/ALT ADDRESS low
+#define ADXL345_ADDRESS_ALT 0x1D // SDO/ALT ADDRESS high
+#define ADXL345_MAX_I2C_CLOCK 400000L
+#define ADXL345_STARTUP_MS 11    // power-up (1.1ms) plus one sample at the default 100Hz
+
 /* ------- Register names ------- */
 #define ADXL345_DEVID 0x00
+#define ADXL345_ID    0xE5 // fixed value of the DEVID register
 #define ADXL345_RESERVED1 0x01
 #define ADXL345_THRESH_TAP 0x1d
 #define ADXL345_OFSX 0x1e
@@ -50,6 +57,14 @@
 #define ADXL345_FIFO_CTL 0x38
 #define ADXL345_FIFO_STATUS 0x39
 
+/* FIFO_CTL modes, OR'd with the watermark sample count */
+#define ADXL345_FIFO_BYPASS  0x00
+#define ADXL345_FIFO_FIFO    0x40
+#define ADXL345_FIFO_STREAM  0x80
+#define ADXL345_FIFO_TRIGGER 0xC0
+#define ADXL345_FIFO_SIZE    32
+#define ADXL345_FIFO_ENTRIES 0x3F // FIFO_STATUS samples held
+
 #define ADXL345_BW_1600 0xF // 1111
 #define ADXL345_BW_800  0xE // 1110
 #define ADXL345_BW_400  0xD // 1101  
@@ -89,7 +104,38 @@
 #define ADXL345_READ_ERROR 1 // problem reading accel
 #define ADXL345_BAD_ARG    2 // bad method argument
 
-class ADXL345
+/*
+ Decoded event registers captured by getSnapshot().
+ ACT_TAP_STATUS (0x2b) to FIFO_STATUS (0x39) are read in one burst, which
+ also returns (and consumes) the current sample from DATAX0..DATAZ1.
+ */
+struct ADXL345Snapshot
+{
+  // INT_SOURCE
+  byte dataReady   : 1;
+  byte singleTap   : 1;
+  byte doubleTap   : 1;
+  byte activity    : 1;
+  byte inactivity  : 1;
+  byte freeFall    : 1;
+  byte watermark   : 1;
+  byte overrun     : 1;
+  // ACT_TAP_STATUS
+  byte activityX   : 1;
+  byte activityY   : 1;
+  byte activityZ   : 1;
+  byte asleep      : 1;
+  byte tapX        : 1;
+  byte tapY        : 1;
+  byte tapZ        : 1;
+  // FIFO_STATUS
+  byte fifoTrigger : 1;
+  byte fifoEntries : 6;
+  // Sample read as part of the burst
+  int x, y, z;
+};
+
+class ADXL345 : public Sensor
 {
 public:
   bool status;           // set when error occurs 
@@ -97,10 +143,11 @@ public:
   byte error_code;       // Initial state
   double gains[3];        // counts to Gs
 
-  ADXL345();
+  ADXL345(int32_t sensorID = -1, uint8_t address = ADXL345_ADDRESS);
   void powerOn();
-  void readAccel(int* xyx);
-  void readAccel(int* x, int* y, int* z);
+  bool begin();
+  uint8_t readAccel(int* xyx);
+  uint8_t readAccel(int* x, int* y, int* z);
   void get_Gxyz(double *xyz);
 
   void setTapThreshold(int tapThreshold);
@@ -163,12 +210,22 @@ public:
 
   bool isLowPower();
   void setLowPower(bool state);
+  bool getLinkBit();
+  void setLinkBit(bool state);
+  bool isAutoSleep();
+  void setAutoSleep(bool state);
   double getRate();
   void setRate(double rate);
   void set_bw(byte bw_code);
   byte get_bw_code();  
 
+  // FIFO, samples in raw counts
+  void setFifoMode(byte mode, byte watermark = 0);
+  byte getFifoEntries();
+  uint8_t readFifo(int16_t (*xyz)[3], uint8_t count);
+
   byte getInterruptSource();
+  uint8_t getSnapshot(ADXL345Snapshot* snapshot);
   bool getInterruptSource(byte interruptBit);
   bool getInterruptMapping(byte interruptBit);
   void setInterruptMapping(byte interruptBit, bool interruptPin);
@@ -189,6 +246,9 @@ public:
   void setJustifyBit(bool justifyBit);
   void printAllRegister();
 
+  uint8_t getEvent(sensors_event_t*);
+  void getSensor(sensor_t*);
+
 private:
   void writeTo(byte address, byte val);
   void readFrom(byte address, int num, byte buff[]);
@@ -0,0 +1,327 @@
+/*
+ADXL345Events.cpp - Interrupt driven motion events for the ADXL345.
+Copyright (C) 2013-2026 G.Pimblott and contributors
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the version 3 GNU General Public License as
+published by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include "ADXL345Events.h"
+
+ADXL345Events *ADXL345Events::attached = NULL;
+
+/************************************************************************/
+/*                                                                      */
+/************************************************************************/
+ADXL345Events::ADXL345Events(ADXL345 *accel)
+{
+	this->accel = accel;
+	pin = 0;
+	adxlPin = ADXL345_INT1_PIN;
+	enabledSources = 0;
+	pending = false;
+	pendingTime = 0;
+	head = 0;
+	count = 0;
+	droppedCount = 0;
+	errorCount = 0;
+	adaptive = false;
+	idle = false;
+	activeBw = ADXL345_BW_100;
+	idleBw = ADXL345_BW_100;
+	rateCode = ADXL345_BW_100;
+	memset(callbacks, 0, sizeof(callbacks));
+}
+
+/************************************************************************/
+/* Map the requested interrupt sources onto one of the ADXL345 pins     */
+/* and attach the ISR to the MCU pin it is wired to                     */
+/************************************************************************/
+bool ADXL345Events::begin(uint8_t mcuPin, bool adxlPin, byte sources)
+{
+	if( attached != NULL && attached != this ) {
+		return false;
+	}
+
+	pin = mcuPin;
+	this->adxlPin = adxlPin;
+	enabledSources = sources;
+	rateCode = accel->get_bw_code() & 0x0F;
+
+	for(byte bit = 0; bit < 8; bit++) {
+		if( sources & (1 << bit) ) {
+			accel->setInterruptMapping(bit, adxlPin);
+		}
+		accel->setInterrupt(bit, (sources >> bit) & 1);
+	}
+
+	/* Interrupts latch until INT_SOURCE is read, so clear anything stale */
+	accel->getInterruptSource();
+
+	attached = this;
+	pinMode(pin, INPUT);
+	attachInterrupt(digitalPinToInterrupt(pin), isr, RISING);
+
+	/* The pin may already be high if an event occured during setup */
+	if( digitalRead(pin) == HIGH ) {
+		pending = true;
+		pendingTime = millis();
+	}
+
+	return true;
+}
+
+/************************************************************************/
+/*                                                                      */
+/************************************************************************/
+void ADXL345Events::end()
+{
+	if( attached == this ) {
+		detachInterrupt(digitalPinToInterrupt(pin));
+		attached = NULL;
+	}
+}
+
+/************************************************************************/
+/* Register a callback for one event type, NULL removes it              */
+/************************************************************************/
+void ADXL345Events::onEvent(uint8_t type, ADXL345EventCallback callback)
+{
+	if( type < ADXL345_EVENT_COUNT ) {
+		callbacks[type] = callback;
+	}
+}
+
+/************************************************************************/
+/* Use the linked activity/inactivity detection with auto sleep to run  */
+/* at activeBw while moving and at idleBw in low power mode while still */
+/* Call after begin(), which chooses the ADXL345 pin.                   */
+/* Thresholds are 62.5mg/LSB and the inactivity time is 1s/LSB.         */
+/* Low power only saves current for idleBw ADXL345_BW_6 (12.5Hz ODR) to */
+/* ADXL345_BW_200 (400Hz ODR)                                           */
+/************************************************************************/
+void ADXL345Events::enableAdaptiveRate(byte activeBw, byte idleBw, int activityThreshold,
+                                       int inactivityThreshold, int timeInactivity)
+{
+	this->activeBw = activeBw;
+	this->idleBw = idleBw;
+
+	accel->setActivityThreshold(activityThreshold);
+	accel->setInactivityThreshold(inactivityThreshold);
+	accel->setTimeInactivity(timeInactivity);
+	accel->setActivityX(true);
+	accel->setActivityY(true);
+	accel->setActivityZ(true);
+	accel->setInactivityX(true);
+	accel->setInactivityY(true);
+	accel->setInactivityZ(true);
+
+	/* Both interrupts drive the switching, on the pin begin() mapped */
+	enabledSources |= (1 << ADXL345_INT_ACTIVITY_BIT) | (1 << ADXL345_INT_INACTIVITY_BIT);
+	accel->setInterruptMapping(ADXL345_INT_ACTIVITY_BIT, adxlPin);
+	accel->setInterruptMapping(ADXL345_INT_INACTIVITY_BIT, adxlPin);
+	accel->setInterrupt(ADXL345_INT_ACTIVITY_BIT, true);
+	accel->setInterrupt(ADXL345_INT_INACTIVITY_BIT, true);
+
+	accel->setLinkBit(true);
+	accel->setAutoSleep(true);
+
+	adaptive = true;
+	idle = true;
+	switchRate(false, millis());
+}
+
+/************************************************************************/
+/* Return to a fixed, full power rate                                   */
+/************************************************************************/
+void ADXL345Events::disableAdaptiveRate()
+{
+	if( !adaptive ) {
+		return;
+	}
+
+	accel->setAutoSleep(false);
+	accel->setLinkBit(false);
+	if( idle ) {
+		switchRate(false, millis());
+	}
+	adaptive = false;
+}
+
+/************************************************************************/
+/* Output data rate in Hz for one of the ADXL345_BW_xxx codes           */
+/************************************************************************/
+float ADXL345Events::rateFromCode(byte bwCode)
+{
+	return 3200.0F / (float)(1UL << (ADXL345_BW_1600 - (bwCode & 0x0F)));
+}
+
+/************************************************************************/
+/*                                                                      */
+/************************************************************************/
+bool ADXL345Events::isPending()
+{
+	return pending;
+}
+
+/************************************************************************/
+/* Called from the main loop. Does nothing unless the interrupt pin has */
+/* fired, in which case the event registers are read with a single      */
+/* snapshot and each active source is dispatched. If the snapshot read  */
+/* fails nothing is dispatched, the error is counted and the interrupt  */
+/* is left pending so the next call tries again.                        */
+/* Returns true if any events were produced.                            */
+/************************************************************************/
+bool ADXL345Events::poll()
+{
+	if( !pending ) {
+		return false;
+	}
+
+	noInterrupts();
+	uint32_t timestamp = pendingTime;
+	pending = false;
+	interrupts();
+
+	ADXL345Snapshot snapshot;
+	if( accel->getSnapshot(&snapshot) != SENSOR_BUS_OK ) {
+		errorCount++;
+		noInterrupts();
+		if( !pending ) {
+			pending = true;
+			pendingTime = timestamp;
+		}
+		interrupts();
+		return false;
+	}
+
+	uint8_t tapAxes = (snapshot.tapX << 2) | (snapshot.tapY << 1) | snapshot.tapZ;
+	uint8_t actAxes = (snapshot.activityX << 2) | (snapshot.activityY << 1) | snapshot.activityZ;
+	uint8_t produced = 0;
+
+	/* A double tap also sets the single tap bit, so report it once */
+	if( snapshot.doubleTap && (enabledSources & (1 << ADXL345_INT_DOUBLE_TAP_BIT)) ) {
+		dispatch(ADXL345_EVENT_DOUBLE_TAP, tapAxes, timestamp);
+		produced++;
+	} else if( snapshot.singleTap && (enabledSources & (1 << ADXL345_INT_SINGLE_TAP_BIT)) ) {
+		dispatch(ADXL345_EVENT_SINGLE_TAP, tapAxes, timestamp);
+		produced++;
+	}
+	if( snapshot.freeFall && (enabledSources & (1 << ADXL345_INT_FREE_FALL_BIT)) ) {
+		dispatch(ADXL345_EVENT_FREE_FALL, 0, timestamp);
+		produced++;
+	}
+	if( snapshot.activity && (enabledSources & (1 << ADXL345_INT_ACTIVITY_BIT)) ) {
+		dispatch(ADXL345_EVENT_ACTIVITY, actAxes, timestamp);
+		produced++;
+	}
+	if( snapshot.inactivity && (enabledSources & (1 << ADXL345_INT_INACTIVITY_BIT)) ) {
+		dispatch(ADXL345_EVENT_INACTIVITY, 0, timestamp);
+		produced++;
+	}
+
+	/* With LINK set only one of the two can be raised at a time */
+	if( adaptive ) {
+		if( snapshot.inactivity && !idle ) {
+			switchRate(true, timestamp);
+			produced++;
+		} else if( snapshot.activity && idle ) {
+			switchRate(false, timestamp);
+			produced++;
+		}
+	}
+	if( snapshot.watermark && (enabledSources & (1 << ADXL345_INT_WATERMARK_BIT)) ) {
+		dispatch(ADXL345_EVENT_WATERMARK, 0, timestamp);
+		produced++;
+	}
+	if( snapshot.overrun && (enabledSources & (1 << ADXL345_INT_OVERRUNY_BIT)) ) {
+		dispatch(ADXL345_EVENT_OVERRUN, 0, timestamp);
+		produced++;
+	}
+
+	return produced != 0;
+}
+
+/************************************************************************/
+/* Take the oldest queued event, returns false if the queue is empty    */
+/************************************************************************/
+bool ADXL345Events::pop(adxl345_event_t *event)
+{
+	if( count == 0 ) {
+		return false;
+	}
+
+	*event = queue[head];
+	head = (head + 1) % ADXL345_EVENT_QUEUE_SIZE;
+	count--;
+	return true;
+}
+
+/************************************************************************/
+/*                                                                      */
+/************************************************************************/
+uint8_t ADXL345Events::available()
+{
+	return count;
+}
+
+/************************************************************************/
+/* Events with a callback are delivered directly, the rest are queued   */
+/************************************************************************/
+void ADXL345Events::dispatch(uint8_t type, uint8_t axes, uint32_t timestamp)
+{
+	adxl345_event_t event;
+	event.type = type;
+	event.axes = axes;
+	event.timestamp = timestamp;
+	event.rateCode = rateCode;
+	event.lowPower = idle;
+
+	if( type < ADXL345_EVENT_COUNT && callbacks[type] != NULL ) {
+		callbacks[type](&event);
+		return;
+	}
+
+	if( count == ADXL345_EVENT_QUEUE_SIZE ) {
+		droppedCount++;
+		return;
+	}
+
+	queue[(head + count) % ADXL345_EVENT_QUEUE_SIZE] = event;
+	count++;
+}
+
+/************************************************************************/
+/* Change the output rate and power mode and report it as an event      */
+/************************************************************************/
+void ADXL345Events::switchRate(bool toIdle, uint32_t timestamp)
+{
+	byte code = toIdle ? idleBw : activeBw;
+
+	accel->set_bw(code);
+	accel->setLowPower(toIdle);
+
+	idle = toIdle;
+	rateCode = code;
+	dispatch(ADXL345_EVENT_RATE_CHANGE, 0, timestamp);
+}
+
+/************************************************************************/
+/*                                                                      */
+/************************************************************************/
+void ADXL345Events::isr()
+{
+	if( attached != NULL ) {
+		attached->pending = true;
+		attached->pendingTime = millis();
+	}
+}
@@ -0,0 +1,123 @@
+/*
+ADXL345Events.h - Interrupt driven motion events for the ADXL345.
+Copyright (C) 2013-2026 G.Pimblott and contributors
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the version 3 GNU General Public License as
+published by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef ADXL345EVENTS_H_
+#define ADXL345EVENTS_H_
+
+#include "Arduino.h"
+#include "ADXL345.h"
+
+#define ADXL345_EVENT_QUEUE_SIZE 8
+
+/** Event types, numbered after the INT_SOURCE bit that raises them */
+typedef enum
+{
+	ADXL345_EVENT_OVERRUN    = ADXL345_INT_OVERRUNY_BIT,
+	ADXL345_EVENT_WATERMARK  = ADXL345_INT_WATERMARK_BIT,
+	ADXL345_EVENT_FREE_FALL  = ADXL345_INT_FREE_FALL_BIT,
+	ADXL345_EVENT_INACTIVITY = ADXL345_INT_INACTIVITY_BIT,
+	ADXL345_EVENT_ACTIVITY   = ADXL345_INT_ACTIVITY_BIT,
+	ADXL345_EVENT_DOUBLE_TAP = ADXL345_INT_DOUBLE_TAP_BIT,
+	ADXL345_EVENT_SINGLE_TAP = ADXL345_INT_SINGLE_TAP_BIT,
+	ADXL345_EVENT_RATE_CHANGE = 7,  /**< adaptive rate switched, see rateCode */
+	ADXL345_EVENT_COUNT      = 8
+} adxl345_event_type_t;
+
+/* Default set of interrupts routed to the pin (everything except data ready) */
+#define ADXL345_EVENT_DEFAULT_SOURCES ( (1 << ADXL345_INT_SINGLE_TAP_BIT) | \
+	(1 << ADXL345_INT_DOUBLE_TAP_BIT) | (1 << ADXL345_INT_ACTIVITY_BIT) | \
+	(1 << ADXL345_INT_INACTIVITY_BIT) | (1 << ADXL345_INT_FREE_FALL_BIT) )
+
+/** A single decoded motion event */
+typedef struct
+{
+	uint8_t  type;      /**< one of adxl345_event_type_t */
+	uint8_t  axes;      /**< tap/activity axes, bit 2 = X, bit 1 = Y, bit 0 = Z */
+	uint8_t  rateCode;  /**< BW_RATE code (ADXL345_BW_xxx) in use after the event */
+	uint8_t  lowPower;  /**< true if the device is in low power mode after the event */
+	uint32_t timestamp; /**< millis() when the interrupt pin fired */
+} adxl345_event_t;
+
+typedef void (*ADXL345EventCallback)(const adxl345_event_t *event);
+
+/************************************************************************/
+/* Routes the ADXL345 interrupt sources to an MCU pin and turns them    */
+/* into typed events. The ISR only records that the pin fired; the      */
+/* registers are read and decoded by poll() from the main loop, so      */
+/* nothing is done on the MCU until the chip reports an event.          */
+/*                                                                      */
+/* In adaptive rate mode inactivity drops the ADXL345 to a low output   */
+/* rate in low power mode and activity restores the full rate; each     */
+/* switch is reported as an ADXL345_EVENT_RATE_CHANGE event.            */
+/*                                                                      */
+/* Only one instance can be attached, as the ISR is a plain function.  */
+/************************************************************************/
+class ADXL345Events {
+	public:
+	ADXL345Events(ADXL345 *accel);
+
+	bool begin(uint8_t mcuPin, bool adxlPin = ADXL345_INT1_PIN,
+	           byte sources = ADXL345_EVENT_DEFAULT_SOURCES);
+	void end();
+
+	void onEvent(uint8_t type, ADXL345EventCallback callback);
+
+	void enableAdaptiveRate(byte activeBw, byte idleBw, int activityThreshold,
+	                        int inactivityThreshold, int timeInactivity);
+	void disableAdaptiveRate();
+	byte getRateCode() { return rateCode; };
+	bool isIdle() { return idle; };
+	static float rateFromCode(byte bwCode);
+
+	bool isPending();
+	bool poll();
+	bool pop(adxl345_event_t *event);
+	uint8_t available();
+	uint16_t dropped() { return droppedCount; };
+	uint16_t errors() { return errorCount; };
+
+	protected:
+	void dispatch(uint8_t type, uint8_t axes, uint32_t timestamp);
+	void switchRate(bool toIdle, uint32_t timestamp);
+
+	ADXL345 *accel;
+
+	private:
+	static void isr();
+	static ADXL345Events *attached;
+
+	uint8_t pin;
+	bool adxlPin;
+	byte enabledSources;
+	volatile bool pending;
+	volatile uint32_t pendingTime;
+
+	bool adaptive;
+	bool idle;
+	byte activeBw;
+	byte idleBw;
+	byte rateCode;
+
+	ADXL345EventCallback callbacks[ADXL345_EVENT_COUNT];
+	adxl345_event_t queue[ADXL345_EVENT_QUEUE_SIZE];
+	uint8_t head;
+	uint8_t count;
+	uint16_t droppedCount;
+	uint16_t errorCount;
+};
+
+#endif /* ADXL345EVENTS_H_ */
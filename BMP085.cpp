@@ -22,11 +22,12 @@
 
 #include "BMP085.h"
 
-static bmp085_calib_data _bmp085_coeffs;   // Last read accelerometer data will be available here
-static uint8_t           _bmp085Mode;
-
 #define BMP085_USE_DATASHEET_VALS (0) /* Set to 1 for sanity check */
 
+/* Conversion times in ms, pressure is indexed by the oversampling mode */
+#define BMP085_TEMPERATURE_MS (5)
+static const uint8_t _bmp085PressureMs[] = { 5, 8, 14, 26 };
+
 /***************************************************************************
  PRIVATE FUNCTIONS
  ***************************************************************************/
@@ -54,17 +55,21 @@ void BMP085::readCoefficients(void)
     _bmp085Mode        = 0;
   #else
   
-    readS16(BMP085_REGISTER_CAL_AC1, &_bmp085_coeffs.ac1);
-    readS16(BMP085_REGISTER_CAL_AC2, &_bmp085_coeffs.ac2);
-    readS16(BMP085_REGISTER_CAL_AC3, &_bmp085_coeffs.ac3);
-    read16(BMP085_REGISTER_CAL_AC4, &_bmp085_coeffs.ac4);
-    read16(BMP085_REGISTER_CAL_AC5, &_bmp085_coeffs.ac5);
-    read16(BMP085_REGISTER_CAL_AC6, &_bmp085_coeffs.ac6);
-    readS16(BMP085_REGISTER_CAL_B1, &_bmp085_coeffs.b1);
-    readS16(BMP085_REGISTER_CAL_B2, &_bmp085_coeffs.b2);
-    readS16(BMP085_REGISTER_CAL_MB, &_bmp085_coeffs.mb);
-    readS16(BMP085_REGISTER_CAL_MC, &_bmp085_coeffs.mc);
-    readS16(BMP085_REGISTER_CAL_MD, &_bmp085_coeffs.md);
+    /* All 11 words are contiguous, so read them in one burst */
+    uint8_t c[BMP085_REGISTER_CAL_MD + 2 - BMP085_REGISTER_CAL_AC1];
+    readBytes(BMP085_REGISTER_CAL_AC1, c, sizeof(c));
+
+    _bmp085_coeffs.ac1 = (int16_t)((c[0] << 8) | c[1]);
+    _bmp085_coeffs.ac2 = (int16_t)((c[2] << 8) | c[3]);
+    _bmp085_coeffs.ac3 = (int16_t)((c[4] << 8) | c[5]);
+    _bmp085_coeffs.ac4 = (uint16_t)((c[6] << 8) | c[7]);
+    _bmp085_coeffs.ac5 = (uint16_t)((c[8] << 8) | c[9]);
+    _bmp085_coeffs.ac6 = (uint16_t)((c[10] << 8) | c[11]);
+    _bmp085_coeffs.b1  = (int16_t)((c[12] << 8) | c[13]);
+    _bmp085_coeffs.b2  = (int16_t)((c[14] << 8) | c[15]);
+    _bmp085_coeffs.mb  = (int16_t)((c[16] << 8) | c[17]);
+    _bmp085_coeffs.mc  = (int16_t)((c[18] << 8) | c[19]);
+    _bmp085_coeffs.md  = (int16_t)((c[20] << 8) | c[21]);
   #endif
 }
 
@@ -78,11 +83,9 @@ void BMP085::readRawTemperature(int32_t *temperature)
   #if BMP085_USE_DATASHEET_VALS
     *temperature = 27898;
   #else
-    uint16_t t;
-    writeCommand(BMP085_REGISTER_CONTROL, BMP085_REGISTER_READTEMPCMD);
-    delay(5);
-    read16(BMP085_REGISTER_TEMPDATA, &t);
-    *temperature = t;
+    startTemperature();
+    delay(BMP085_TEMPERATURE_MS);
+    readTemperatureResult(temperature);
   #endif
 }
 
@@ -96,51 +99,96 @@ void BMP085::readRawPressure(int32_t *pressure)
   #if BMP085_USE_DATASHEET_VALS
     *pressure = 23843;
   #else
-    uint8_t  p8;
-    uint16_t p16;
-    int32_t  p32;
-
-    writeCommand(BMP085_REGISTER_CONTROL, BMP085_REGISTER_READPRESSURECMD + (_bmp085Mode << 6));
-    switch(_bmp085Mode)
-    {
-      case BMP085_MODE_ULTRALOWPOWER:
-        delay(5);
-        break;
-      case BMP085_MODE_STANDARD:
-        delay(8);
-        break;
-      case BMP085_MODE_HIGHRES:
-        delay(14);
-        break;
-      case BMP085_MODE_ULTRAHIGHRES:
-      default:
-        delay(26);
-        break;
-    }
-
-    read16(BMP085_REGISTER_PRESSUREDATA, &p16);
-    p32 = (uint32_t)p16 << 8;
-    read8(BMP085_REGISTER_PRESSUREDATA+2, &p8);
-    p32 += p8;
-    p32 >>= (8 - _bmp085Mode);
-    
-    *pressure = p32;
+    startPressure();
+    delay(_bmp085PressureMs[_bmp085Mode]);
+    readPressureResult(pressure);
   #endif
 }
 
 /***************************************************************************
  PUBLIC FUNCTIONS
  ***************************************************************************/
+
+/**************************************************************************/
+/*!
+    @brief  Time taken by a pressure conversion in the given mode, or by
+            a temperature conversion for BMP085_CONVERSION_TEMPERATURE
+*/
+/**************************************************************************/
+uint32_t BMP085::conversionMicros(int8_t mode)
+{
+  if (mode < 0 || mode > BMP085_MODE_ULTRAHIGHRES)
+  {
+    return BMP085_TEMPERATURE_MS * 1000L;
+  }
+  return _bmp085PressureMs[mode] * 1000L;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Starts a temperature conversion without waiting for it
+*/
+/**************************************************************************/
+void BMP085::startTemperature(void)
+{
+  writeCommand(BMP085_REGISTER_CONTROL, BMP085_REGISTER_READTEMPCMD);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Starts a pressure conversion in the configured mode without
+            waiting for it
+*/
+/**************************************************************************/
+void BMP085::startPressure(void)
+{
+  writeCommand(BMP085_REGISTER_CONTROL, BMP085_REGISTER_READPRESSURECMD + (_bmp085Mode << 6));
+  _pressureReady = micros() + conversionMicros(_bmp085Mode);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Reads UT once a temperature conversion has had time to finish,
+            returns the first bus failure since the last clearError()
+*/
+/**************************************************************************/
+uint8_t BMP085::readTemperatureResult(int32_t *temperature)
+{
+  uint16_t t;
+  read16(BMP085_REGISTER_TEMPDATA, &t);
+  *temperature = t;
+  return bus->getError();
+}
+
+/**************************************************************************/
+/*!
+    @brief  Reads UP once a pressure conversion has had time to finish,
+            returns the first bus failure since the last clearError()
+*/
+/**************************************************************************/
+uint8_t BMP085::readPressureResult(int32_t *pressure)
+{
+  uint8_t  p[3];
+  int32_t  p32;
+
+  /* MSB, LSB and XLSB in one burst */
+  readBytes(BMP085_REGISTER_PRESSUREDATA, p, 3);
+  p32 = ((uint32_t)p[0] << 16) | ((uint32_t)p[1] << 8) | p[2];
+  p32 >>= (8 - _bmp085Mode);
+  
+  *pressure = p32;
+  return bus->getError();
+}
  
 /**************************************************************************/
 /*!
     @brief  Setups the HW
 */
 /**************************************************************************/
-bool BMP085::begin(bmp085_mode_t mode)
+bool BMP085::begin(bmp085_mode_t mode, const bmp085_calib_data *coeffs)
 {
   // Enable I2C
-  Wire.begin();
+  bus->begin();
 
   /* Mode boundary check */
   if ((mode > BMP085_MODE_ULTRAHIGHRES) || (mode < 0))
@@ -151,7 +199,7 @@ bool BMP085::begin(bmp085_mode_t mode)
   /* Make sure we have the right device */
   uint8_t id;
   read8(BMP085_REGISTER_CHIPID, &id);
-  if(id != 0x55)
+  if(id != BMP085_CHIPID)
   {
     return false;
   }
@@ -159,12 +207,51 @@ bool BMP085::begin(bmp085_mode_t mode)
   /* Set the mode indicator */
   _bmp085Mode = mode;
 
-  /* Coefficients need to be read once */
-  readCoefficients();
+  /* Coefficients need to be read once, unless they were saved earlier.
+     AC1 is read back as a fingerprint so a different part fitted since
+     they were saved isn't run on the old part's coefficients. */
+  int16_t ac1 = 0;
+  if (coeffs != NULL)
+  {
+    readS16(BMP085_REGISTER_CAL_AC1, &ac1);
+  }
+  if (coeffs != NULL && ac1 == coeffs->ac1)
+  {
+    _bmp085_coeffs = *coeffs;
+  }
+  else
+  {
+    readCoefficients();
+  }
     
   return true;
 }
 
+/**************************************************************************/
+/*!
+    @brief  Changes the oversampling mode used by the next pressure
+            conversion
+*/
+/**************************************************************************/
+void BMP085::setMode(bmp085_mode_t mode)
+{
+  if (mode <= BMP085_MODE_ULTRAHIGHRES)
+  {
+    _bmp085Mode = mode;
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief  Copies out the factory coefficients, e.g. to store them so a
+            later begin() can skip reading them from the device
+*/
+/**************************************************************************/
+void BMP085::getCoefficients(bmp085_calib_data *coeffs)
+{
+  *coeffs = _bmp085_coeffs;
+}
+
 /**************************************************************************/
 /*!
     @brief  Gets the compensated pressure level in kPa
@@ -172,14 +259,26 @@ bool BMP085::begin(bmp085_mode_t mode)
 /**************************************************************************/
 void BMP085::getPressure(float *pressure)
 {
-  int32_t  ut = 0, up = 0, compp = 0;
-  int32_t  x1, x2, b5, b6, x3, b3, p;
-  uint32_t b4, b7;
+  int32_t  ut = 0, up = 0;
 
   /* Get the raw pressure and temperature values */
   readRawTemperature(&ut);
   readRawPressure(&up);
 
+  /* Assign compensated pressure value */
+  *pressure = compensatePressure(ut, up);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Compensated pressure in Pa from raw UT and UP readings
+*/
+/**************************************************************************/
+int32_t BMP085::compensatePressure(int32_t ut, int32_t up)
+{
+  int32_t  x1, x2, b5, b6, x3, b3, p;
+  uint32_t b4, b7;
+
   /* Temperature compensation */
   x1 = (ut - (int32_t)(_bmp085_coeffs.ac6))*((int32_t)(_bmp085_coeffs.ac5))/pow(2,15);
   x2 = ((int32_t)(_bmp085_coeffs.mc*pow(2,11)))/(x1+(int32_t)(_bmp085_coeffs.md));
@@ -209,10 +308,7 @@ void BMP085::getPressure(float *pressure)
   x1 = (p >> 8) * (p >> 8);
   x1 = (x1 * 3038) >> 16;
   x2 = (-7357 * p) >> 16;
-  compp = p + ((x1 + x2 + 3791) >> 4);
-
-  /* Assign compensated pressure value */
-  *pressure = compp;
+  return p + ((x1 + x2 + 3791) >> 4);
 }
 
 /**************************************************************************/
@@ -222,10 +318,21 @@ void BMP085::getPressure(float *pressure)
 /**************************************************************************/
 void BMP085::getTemperature(float *temp)
 {
-  int32_t UT, X1, X2, B5;     // following ds convention
-  float t;
+  int32_t UT;
 
   readRawTemperature(&UT);
+  *temp = compensateTemperature(UT);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Temperature in degrees Celsius from a raw UT reading
+*/
+/**************************************************************************/
+float BMP085::compensateTemperature(int32_t UT)
+{
+  int32_t X1, X2, B5;     // following ds convention
+  float t;
 
   #if BMP085_USE_DATASHEET_VALS
     // use datasheet numbers!
@@ -243,7 +350,7 @@ void BMP085::getTemperature(float *temp)
   t = (B5+8)/pow(2,4);
   t /= 10;
 
-  *temp = t;
+  return t;
 }
 
 /**************************************************************************/
@@ -297,10 +404,11 @@ void BMP085::getSensor(sensor_t *sensor)
 
 /**************************************************************************/
 /*!
-    @brief  Reads the sensor and returns the data as a sensors_event_t
+    @brief  Reads the sensor and returns the data as a sensors_event_t,
+            returns the bus status
 */
 /**************************************************************************/
-void BMP085::getEvent(sensors_event_t *event)
+uint8_t BMP085::getEvent(sensors_event_t *event)
 {
   float pressure_kPa;
 
@@ -310,7 +418,9 @@ void BMP085::getEvent(sensors_event_t *event)
   event->version   = sizeof(sensors_event_t);
   event->sensor_id = deviceId;
   event->type      = SENSOR_TYPE_PRESSURE;
-  event->timestamp = 0;
+  bus->clearError();
   getPressure(&pressure_kPa);
   event->pressure = pressure_kPa / 100.0F; /* kPa to hPa */
+  stampEvent(event, _pressureReady);
+  return bus->getError();
 }
@@ -24,6 +24,9 @@
     I2C ADDRESS/BITS
     -----------------------------------------------------------------------*/
     #define BMP085_ADDRESS                (0x77)
+    #define BMP085_MAX_I2C_CLOCK          (3400000L)  // high-speed mode
+    #define BMP085_CHIPID                 (0x55)
+    #define BMP085_STARTUP_MS             (10)   // power-up to first conversion
 /*=========================================================================*/
 
 /*=========================================================================
@@ -63,6 +66,8 @@
       BMP085_MODE_HIGHRES                = 2,
       BMP085_MODE_ULTRAHIGHRES           = 3
     } bmp085_mode_t;
+
+    #define BMP085_CONVERSION_TEMPERATURE  (-1)   // for conversionMicros()
 /*=========================================================================*/
 
 /*=========================================================================
@@ -87,16 +92,38 @@
 class BMP085 : public Sensor
 {
   public:
-    BMP085(int32_t sensorID = -1) : Sensor( BMP085_ADDRESS , sensorID ) {};
+    BMP085(int32_t sensorID = -1) : Sensor( BMP085_ADDRESS , sensorID ) {
+      i2c.setMaxClock(BMP085_MAX_I2C_CLOCK);
+      _bmp085Mode = BMP085_MODE_ULTRAHIGHRES;
+      _pressureReady = 0;
+      memset(&_bmp085_coeffs, 0, sizeof(_bmp085_coeffs));
+    };
   
-    bool  begin(bmp085_mode_t mode = BMP085_MODE_ULTRAHIGHRES);
+    bool  begin(bmp085_mode_t mode = BMP085_MODE_ULTRAHIGHRES,
+                const bmp085_calib_data *coeffs = NULL);
+    void  getCoefficients(bmp085_calib_data *coeffs);
     void  getTemperature(float *temp);
     void  getPressure(float *pressure);
     float pressureToAltitude(float seaLevel, float atmospheric, float temp);
-    void  getEvent(sensors_event_t*);
+
+    /* Split conversions, for sampling several devices at once */
+    void  startTemperature(void);
+    void  startPressure(void);
+    uint8_t readTemperatureResult(int32_t *temperature);
+    uint8_t readPressureResult(int32_t *pressure);
+    int32_t compensatePressure(int32_t ut, int32_t up);
+    float compensateTemperature(int32_t ut);
+    bmp085_mode_t getMode(void) { return (bmp085_mode_t)_bmp085Mode; };
+    void  setMode(bmp085_mode_t mode);
+    static uint32_t conversionMicros(int8_t mode);
+    uint8_t getEvent(sensors_event_t*);
     void  getSensor(sensor_t*);
 
   private:
+	bmp085_calib_data _bmp085_coeffs;   // Factory calibration for this device
+	uint8_t           _bmp085Mode;
+	uint32_t          _pressureReady;   // micros() when the last pressure conversion completes
+
 	void readCoefficients(void);
 	void readRawTemperature(int32_t *temperature);
 	void readRawPressure(int32_t *pressure);
@@ -0,0 +1,207 @@
+/*
+BMP085 software oversampler.
+Copyright (C) 2013-2026 G.Pimblott and contributors
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the version 3 GNU General Public License as
+published by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include "Arduino.h"
+
+#include "BMP085Oversampler.h"
+
+/**************************************************************************/
+/*!
+    @brief  The device must already have been started with begin(). The
+            default is a 16 conversion average with an output for each
+            16 conversions.
+*/
+/**************************************************************************/
+BMP085Oversampler::BMP085Oversampler(BMP085 *device) : _sampler(&_device, 1)
+{
+  _device      = device;
+  _status      = SENSOR_BUS_OK;
+  _filter      = BMP085_FILTER_AVERAGE;
+  _length      = 16;
+  _every       = 16;
+  reset();
+}
+
+/**************************************************************************/
+/*!
+    @brief  Switches the device to the given mode and starts converting
+*/
+/**************************************************************************/
+void BMP085Oversampler::begin(bmp085_mode_t mode)
+{
+  _device->setMode(mode);
+  reset();
+
+  /* Temperature first, pressures can't be compensated without it */
+  _sampler.start(true);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Moving average over length conversions, 1 to
+            BMP085_OVERSAMPLE_MAX. Restarts the filter.
+*/
+/**************************************************************************/
+void BMP085Oversampler::setAverage(uint8_t length)
+{
+  _filter = BMP085_FILTER_AVERAGE;
+  _length = constrain(length, 1, BMP085_OVERSAMPLE_MAX);
+  reset();
+}
+
+/**************************************************************************/
+/*!
+    @brief  First order IIR, each conversion moves the output 1/2^shift
+            of the way towards it. Restarts the filter.
+*/
+/**************************************************************************/
+void BMP085Oversampler::setIIR(uint8_t shift)
+{
+  _filter = BMP085_FILTER_IIR;
+  _length = constrain(shift, 0, 8);
+  reset();
+}
+
+/**************************************************************************/
+/*!
+    @brief  One output for every 'every' conversions
+*/
+/**************************************************************************/
+void BMP085Oversampler::setDecimation(uint8_t every)
+{
+  _every = every > 0 ? every : 1;
+  _sinceOutput = 0;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Time between outputs, counting the temperature refreshes
+*/
+/**************************************************************************/
+uint32_t BMP085Oversampler::outputMicros(void)
+{
+  uint32_t pressure = BMP085::conversionMicros(_device->getMode());
+  uint32_t temperature = BMP085::conversionMicros(BMP085_CONVERSION_TEMPERATURE);
+
+  return _every * pressure + _every * temperature / BMP085_TEMPERATURE_EVERY;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Collects a finished conversion and starts the next one.
+            Returns true when there is a new output.
+*/
+/**************************************************************************/
+bool BMP085Oversampler::poll(void)
+{
+  bool output = false;
+
+  if (!_sampler.poll())
+  {
+    return false;
+  }
+
+  _status = _sampler.getStatus(0);
+  if (_status == SENSOR_BUS_OK)
+  {
+    filter(_sampler.getPressurePa(0));
+
+    /* Only report once the average holds a full window */
+    if (++_sinceOutput >= _every && _filled >= _length)
+    {
+      _sinceOutput = 0;
+      output = true;
+    }
+  }
+
+  /* Straight on to the next cycle, starting over from the temperature
+     after a failed read in case there is no good UT yet */
+  if (++_sinceTemperature >= BMP085_TEMPERATURE_EVERY ||
+      _status != SENSOR_BUS_OK)
+  {
+    _sinceTemperature = 0;
+    _sampler.start(true);
+  }
+  else
+  {
+    _sampler.start(false);
+  }
+
+  return output;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Blocking wait for the next output, only for a device that
+            is known to respond
+*/
+/**************************************************************************/
+void BMP085Oversampler::sample(void)
+{
+  while (!poll())
+  {
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief  Empties the filter, the next output waits for a full window
+*/
+/**************************************************************************/
+void BMP085Oversampler::reset(void)
+{
+  _sinceTemperature = 0;
+  _sinceOutput      = 0;
+  _head             = 0;
+  _filled           = 0;
+  _sum              = 0;
+  _output           = 0;
+  memset(_history, 0, sizeof(_history));
+}
+
+/**************************************************************************/
+/*!
+    @brief  Adds one compensated pressure in Pa to the filter
+*/
+/**************************************************************************/
+void BMP085Oversampler::filter(int32_t pressure)
+{
+  if (_filter == BMP085_FILTER_IIR)
+  {
+    /* Start from the first conversion rather than ramping up from 0 */
+    if (_filled == 0)
+    {
+      _output = pressure << 8;
+      _filled = _length;
+    }
+    else
+    {
+      _output += ((pressure << 8) - _output) >> _length;
+    }
+    return;
+  }
+
+  /* Running sum over a ring of the last _length conversions */
+  _sum += pressure - _history[_head];
+  _history[_head] = pressure;
+  _head = (_head + 1) % _length;
+  if (_filled < _length)
+  {
+    _filled++;
+  }
+  _output = (_sum << 8) / _filled;
+}
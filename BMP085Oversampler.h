@@ -0,0 +1,85 @@
+/*
+Header file for the BMP085 software oversampler.
+Copyright (C) 2013-2026 G.Pimblott and contributors
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the version 3 GNU General Public License as
+published by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef __BMP085OVERSAMPLER_H__
+#define __BMP085OVERSAMPLER_H__
+
+#include "BMP085.h"
+#include "BMP085Sampler.h"
+
+#define BMP085_OVERSAMPLE_MAX       (32)   // longest moving average
+#define BMP085_TEMPERATURE_EVERY    (32)   // pressure conversions per temperature
+
+typedef enum
+{
+  BMP085_FILTER_AVERAGE          = 0,
+  BMP085_FILTER_IIR              = 1
+} bmp085_filter_t;
+
+/*=========================================================================
+    Rather than one long hardware oversampled conversion (26ms in
+    ULTRAHIGHRES), short conversions run back to back and are filtered
+    here. Each pressure is compensated as it arrives and fed to either a
+    moving average or a first order IIR, and every Nth conversion becomes
+    an output. Averaging 16 ULTRALOWPOWER conversions (0.06hPa RMS each)
+    gives about the ULTRAHIGHRES noise, at a rate and with a smoothing
+    that can be changed while running.
+
+    The conversions are run by a BMP085Sampler over the one device, with
+    the temperature refreshed every BMP085_TEMPERATURE_EVERY pressure
+    conversions. poll() never waits, so call it often; each call that
+    finds a conversion finished starts the next one straight away. A
+    failed read is left out of the filter and reported by getStatus().
+    -----------------------------------------------------------------------*/
+class BMP085Oversampler
+{
+  public:
+    BMP085Oversampler(BMP085 *device);
+
+    void  begin(bmp085_mode_t mode = BMP085_MODE_ULTRALOWPOWER);
+    void  setAverage(uint8_t length);
+    void  setIIR(uint8_t shift);
+    void  setDecimation(uint8_t every);
+    bool  poll(void);
+    void  sample(void);
+    uint8_t getStatus(void) { return _status; };
+
+    int32_t  getPressurePa(void) { return (_output + 128) >> 8; };
+    float    getPressure(void) { return _output / 25600.0F; };
+    float    getTemperature(void) { return _sampler.getTemperature(0); };
+    uint32_t outputMicros(void);
+
+  private:
+    void  reset(void);
+    void  filter(int32_t pressure);
+
+    BMP085   *_device;
+    BMP085Sampler _sampler;
+    uint8_t  _status;        // of the last finished conversion
+    uint8_t  _filter;
+    uint8_t  _length;        // average length or IIR shift
+    uint8_t  _every;
+    uint8_t  _sinceTemperature;
+    uint8_t  _sinceOutput;
+    uint8_t  _head;
+    uint8_t  _filled;
+    int32_t  _sum;
+    int32_t  _output;        // Pa, Q8
+    int32_t  _history[BMP085_OVERSAMPLE_MAX];
+};
+
+#endif
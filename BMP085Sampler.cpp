@@ -0,0 +1,175 @@
+/*
+Pipelined BMP085 sampler.
+Copyright (C) 2013-2026 G.Pimblott and contributors
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the version 3 GNU General Public License as
+published by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include "Arduino.h"
+
+#include "BMP085Sampler.h"
+
+enum
+{
+  BMP085_PHASE_IDLE,
+  BMP085_PHASE_TEMPERATURE,
+  BMP085_PHASE_PRESSURE
+};
+
+/**************************************************************************/
+/*!
+    @brief  Devices must already have been started with begin()
+*/
+/**************************************************************************/
+BMP085Sampler::BMP085Sampler(BMP085 **devices, uint8_t count)
+{
+  _devices   = devices;
+  _count     = count > BMP085_SAMPLER_MAX ? BMP085_SAMPLER_MAX : count;
+  _remaining = 0;
+
+  for (uint8_t i = 0; i < _count; i++)
+  {
+    _phase[i]       = BMP085_PHASE_IDLE;
+    _status[i]      = SENSOR_BUS_OK;
+    _ut[i]          = 0;
+    _pressure[i]    = 0;
+    _temperature[i] = 0;
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief  Starts a cycle on every device. Without temperature only the
+            pressure is converted and compensated with the UT of the
+            last cycle that did read it.
+*/
+/**************************************************************************/
+void BMP085Sampler::start(bool temperature)
+{
+  for (uint8_t i = 0; i < _count; i++)
+  {
+    if (temperature)
+    {
+      _devices[i]->startTemperature();
+      _phase[i] = BMP085_PHASE_TEMPERATURE;
+    }
+    else
+    {
+      _devices[i]->startPressure();
+      _phase[i] = BMP085_PHASE_PRESSURE;
+    }
+    _startedAt[i] = micros();
+    _status[i] = SENSOR_BUS_OK;
+  }
+  _remaining = _count;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Collects any conversions that have finished and starts the
+            next phase on those devices. Returns true once every device
+            has a new pressure and temperature.
+*/
+/**************************************************************************/
+bool BMP085Sampler::poll(void)
+{
+  if (_remaining == 0)
+  {
+    return false;
+  }
+
+  for (uint8_t i = 0; i < _count; i++)
+  {
+    uint32_t elapsed = micros() - _startedAt[i];
+
+    switch (_phase[i])
+    {
+      case BMP085_PHASE_TEMPERATURE:
+        if (elapsed >= BMP085::conversionMicros(BMP085_CONVERSION_TEMPERATURE))
+        {
+          int32_t ut;
+          _devices[i]->getBus()->clearError();
+          _status[i] = _devices[i]->readTemperatureResult(&ut);
+          if (_status[i] != SENSOR_BUS_OK)
+          {
+            _phase[i] = BMP085_PHASE_IDLE;
+            _remaining--;
+            break;
+          }
+          _ut[i] = ut;
+          _devices[i]->startPressure();
+          _startedAt[i] = micros();
+          _phase[i] = BMP085_PHASE_PRESSURE;
+        }
+        break;
+
+      case BMP085_PHASE_PRESSURE:
+        if (elapsed >= BMP085::conversionMicros(_devices[i]->getMode()))
+        {
+          int32_t up;
+          _devices[i]->getBus()->clearError();
+          _status[i] = _devices[i]->readPressureResult(&up);
+          if (_status[i] == SENSOR_BUS_OK)
+          {
+            _pressure[i]    = _devices[i]->compensatePressure(_ut[i], up);
+            _temperature[i] = _devices[i]->compensateTemperature(_ut[i]);
+          }
+          _phase[i] = BMP085_PHASE_IDLE;
+          _remaining--;
+        }
+        break;
+    }
+  }
+
+  return _remaining == 0;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Blocking read of every device. Returns false if there are
+            no devices, or if the cycle overran the longest conversion
+            times, in which case the unfinished devices are dropped with
+            SENSOR_BUS_TIMEOUT.
+*/
+/**************************************************************************/
+bool BMP085Sampler::sample(void)
+{
+  if (_count == 0)
+  {
+    return false;
+  }
+
+  uint32_t limit = BMP085::conversionMicros(BMP085_CONVERSION_TEMPERATURE) +
+                   BMP085::conversionMicros(BMP085_MODE_ULTRAHIGHRES) +
+                   BMP085_SAMPLER_MARGIN_MICROS;
+  uint32_t started = micros();
+
+  start();
+  while (!poll())
+  {
+    if (micros() - started >= limit)
+    {
+      for (uint8_t i = 0; i < _count; i++)
+      {
+        if (_phase[i] != BMP085_PHASE_IDLE)
+        {
+          _phase[i]  = BMP085_PHASE_IDLE;
+          _status[i] = SENSOR_BUS_TIMEOUT;
+        }
+      }
+      _remaining = 0;
+      return false;
+    }
+  }
+  return true;
+}
@@ -0,0 +1,73 @@
+/*
+Header file for the pipelined BMP085 sampler.
+Copyright (C) 2013-2026 G.Pimblott and contributors
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the version 3 GNU General Public License as
+published by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef __BMP085SAMPLER_H__
+#define __BMP085SAMPLER_H__
+
+#include "BMP085.h"
+
+#define BMP085_SAMPLER_MAX   (4)
+
+/* sample() gives up on a cycle after a temperature and the slowest
+   pressure conversion plus this margin */
+#define BMP085_SAMPLER_MARGIN_MICROS  (10000L)
+
+/*=========================================================================
+    Each BMP085 has the fixed address 0x77 and there is no second I2C
+    bus or multiplexer transport for Sensor::setBus, so on a real board
+    this samples one device (as BMP085Oversampler does). More than one
+    only runs on SimulatedBus, see DriverBenchmark.
+
+    Instead of running every device's temperature and pressure conversion
+    back to back, all conversions are started together and each result is
+    collected as soon as its conversion time has passed, at which point
+    that device moves straight on to its next phase. N barometers take
+    about as long as the slowest one.
+
+    A device whose result read fails is dropped from the cycle and keeps
+    its previous reading, getStatus() gives the bus status of its read.
+    One still unfinished when sample() gives up reports SENSOR_BUS_TIMEOUT.
+    -----------------------------------------------------------------------*/
+class BMP085Sampler
+{
+  public:
+    BMP085Sampler(BMP085 **devices, uint8_t count);
+
+    void  start(bool temperature = true);
+    bool  poll(void);
+    bool  isBusy(void) { return _remaining != 0; };
+    bool  sample(void);
+
+    uint8_t getStatus(uint8_t index) { return _status[index]; };
+    int32_t getPressurePa(uint8_t index) { return _pressure[index]; };
+    float getPressure(uint8_t index) { return _pressure[index] / 100.0F; };
+    float getTemperature(uint8_t index) { return _temperature[index]; };
+    uint8_t size(void) { return _count; };
+
+  private:
+    BMP085   **_devices;
+    uint8_t  _count;
+    uint8_t  _remaining;
+    uint8_t  _phase[BMP085_SAMPLER_MAX];
+    uint8_t  _status[BMP085_SAMPLER_MAX];
+    uint32_t _startedAt[BMP085_SAMPLER_MAX];
+    int32_t  _ut[BMP085_SAMPLER_MAX];
+    int32_t  _pressure[BMP085_SAMPLER_MAX];
+    float    _temperature[BMP085_SAMPLER_MAX];
+};
+
+#endif
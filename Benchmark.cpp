@@ -0,0 +1,153 @@
+/*
+Benchmark runner.
+Copyright (C) 2013-2026 G.Pimblott and contributors
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the version 3 GNU General Public License as
+published by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include "Benchmark.h"
+
+#define BENCHMARK_CALIBRATION_CALLS 1000
+#define BENCHMARK_CYCLES_PER_US (F_CPU / 1000000L)
+
+static void emptyFunction()
+{
+}
+
+/************************************************************************/
+/*                                                                      */
+/************************************************************************/
+Benchmark::Benchmark(Print *out)
+{
+	this->out = out;
+	overhead = 0;
+	cycleOverhead = 0;
+}
+
+/************************************************************************/
+/* Measure the call overhead and print the CSV header                   */
+/************************************************************************/
+void Benchmark::begin()
+{
+	uint32_t least, mean;
+
+	overhead = elapsed(emptyFunction, BENCHMARK_CALIBRATION_CALLS) * 1000.0F / BENCHMARK_CALIBRATION_CALLS;
+	cycleOverhead = 0;
+	if( cycles(emptyFunction, BENCHMARK_CALIBRATION_CALLS, &least, &mean) ) {
+		cycleOverhead = least;
+	}
+	out->println("name,calls,total_us,ns_per_call,calls_per_sec,cycles_min,cycles_mean");
+}
+
+/************************************************************************/
+/* Time calls to fn and print a CSV row, returns ns per call. Use       */
+/* enough calls for the total to be well above the 4us micros() step.   */
+/************************************************************************/
+float Benchmark::run(const char *name, benchmark_fn_t fn, uint16_t calls)
+{
+	uint32_t total = elapsed(fn, calls);
+	float ns = total * 1000.0F / calls - overhead;
+	uint32_t least, mean;
+
+	if( ns < 0 ) {
+		ns = 0;
+	}
+
+	if( !cycles(fn, calls, &least, &mean) ) {
+		least = mean = ns * BENCHMARK_CYCLES_PER_US / 1000.0F;
+	}
+
+	out->print(name);
+	out->print(",");
+	out->print(calls);
+	out->print(",");
+	out->print(total);
+	out->print(",");
+	out->print(ns, 0);
+	out->print(",");
+	out->print(ns > 0 ? 1.0e9F / ns : 0, 0);
+	out->print(",");
+	out->print(least);
+	out->print(",");
+	out->println(mean);
+	return ns;
+}
+
+/************************************************************************/
+/*                                                                      */
+/************************************************************************/
+uint32_t Benchmark::elapsed(benchmark_fn_t fn, uint16_t calls)
+{
+	uint32_t start = micros();
+
+	for(uint16_t i = 0; i < calls; i++) {
+		fn();
+	}
+	return micros() - start;
+}
+
+/************************************************************************/
+/* Cycles for the fastest call and the average over all calls, less the */
+/* cost of an empty call. False if there is no cycle counter or a call  */
+/* outran it.                                                           */
+/************************************************************************/
+bool Benchmark::cycles(benchmark_fn_t fn, uint16_t calls, uint32_t *least, uint32_t *mean)
+{
+#if defined(__AVR__)
+	uint8_t savedA = TCCR1A;
+	uint8_t savedB = TCCR1B;
+	uint8_t savedMask = TIMSK1;
+	uint32_t sum = 0;
+	uint16_t best = 0xFFFF;
+	bool overflow = false;
+
+	/* Normal mode, no prescaler, no interrupts */
+	TIMSK1 = 0;
+	TCCR1A = 0;
+	TCCR1B = _BV(CS10);
+
+	for(uint16_t i = 0; i < calls && !overflow; i++) {
+		TCNT1 = 0;
+		TIFR1 = _BV(TOV1);
+		fn();
+		uint16_t count = TCNT1;
+
+		if( TIFR1 & _BV(TOV1) ) {
+			overflow = true;
+		} else {
+			count = count > cycleOverhead ? count - cycleOverhead : 0;
+			sum += count;
+			if( count < best ) {
+				best = count;
+			}
+		}
+	}
+
+	TCCR1B = savedB;
+	TCCR1A = savedA;
+	TIMSK1 = savedMask;
+
+	if( overflow ) {
+		return false;
+	}
+	*least = best;
+	*mean = sum / calls;
+	return true;
+#else
+	(void)fn;
+	(void)calls;
+	(void)least;
+	(void)mean;
+	return false;
+#endif
+}
@@ -0,0 +1,55 @@
+/*
+Header file for the benchmark runner.
+Copyright (C) 2013-2026 G.Pimblott and contributors
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the version 3 GNU General Public License as
+published by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef BENCHMARK_H_
+#define BENCHMARK_H_
+
+#include "Arduino.h"
+
+typedef void (*benchmark_fn_t)(void);
+
+/************************************************************************/
+/* Times a function over a number of calls and prints one CSV row per   */
+/* function, so results can be captured from the serial port and        */
+/* compared between builds.                                             */
+/*                                                                      */
+/* The cost of calling an empty function is measured by begin() and     */
+/* taken off every result.                                              */
+/*                                                                      */
+/* On AVR each call is also timed in CPU cycles with Timer1 running at  */
+/* the CPU clock. The minimum is free of interrupt noise; calls longer  */
+/* than 65535 cycles fall back to the micros() figure. Elsewhere the    */
+/* cycles are estimated from the time and F_CPU.                        */
+/************************************************************************/
+class Benchmark {
+	public:
+	Benchmark(Print *out);
+
+	void begin();
+	float run(const char *name, benchmark_fn_t fn, uint16_t calls);
+
+	private:
+	uint32_t elapsed(benchmark_fn_t fn, uint16_t calls);
+	bool cycles(benchmark_fn_t fn, uint16_t calls, uint32_t *least, uint32_t *mean);
+
+	Print *out;
+	float overhead;  /* ns per call of an empty function */
+	uint16_t cycleOverhead;
+};
+
+#endif /* BENCHMARK_H_ */
@@ -0,0 +1,185 @@
+/*
+Fixed-point biquad filter bank.
+Copyright (C) 2013-2026 G.Pimblott and contributors
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the version 3 GNU General Public License as
+published by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include "BiquadBank.h"
+
+/************************************************************************/
+/* channels is clipped to BIQUAD_MAX_CHANNELS. With no sections added   */
+/* process() passes samples straight through.                           */
+/************************************************************************/
+BiquadBank::BiquadBank(uint8_t channels)
+{
+	this->channels = channels < BIQUAD_MAX_CHANNELS ? channels : BIQUAD_MAX_CHANNELS;
+	sections = 0;
+	memset(coeffs, 0, sizeof(coeffs));
+	reset();
+}
+
+/************************************************************************/
+/* Append a section to the cascade, false when the bank is full         */
+/************************************************************************/
+bool BiquadBank::addSection(const biquad_t *section)
+{
+	if( sections >= BIQUAD_MAX_SECTIONS ) {
+		return false;
+	}
+	coeffs[sections++] = *section;
+	return true;
+}
+
+/************************************************************************/
+/* Clear the history of every channel                                   */
+/************************************************************************/
+void BiquadBank::reset()
+{
+	memset(in1, 0, sizeof(in1));
+	memset(in2, 0, sizeof(in2));
+	memset(out1, 0, sizeof(out1));
+	memset(out2, 0, sizeof(out2));
+	memset(residue, 0, sizeof(residue));
+}
+
+/************************************************************************/
+/* Filter one sample per channel in place                               */
+/************************************************************************/
+void BiquadBank::process(int16_t *samples)
+{
+	process(samples, samples);
+}
+
+/************************************************************************/
+/* Filter one sample per channel. Each section runs across all the      */
+/* channels before the next, so the inner loop is the same arithmetic   */
+/* on neighbouring array elements.                                      */
+/************************************************************************/
+void BiquadBank::process(const int16_t *in, int16_t *out)
+{
+	int16_t v[BIQUAD_MAX_CHANNELS];
+
+	memcpy(v, in, channels * sizeof(int16_t));
+
+	for(uint8_t s = 0; s < sections; s++) {
+		const biquad_t c = coeffs[s];
+		int16_t *i1 = in1[s];
+		int16_t *i2 = in2[s];
+		int16_t *o1 = out1[s];
+		int16_t *o2 = out2[s];
+		int16_t *r = residue[s];
+
+		for(uint8_t ch = 0; ch < channels; ch++) {
+#ifdef BIQUAD_SATURATING
+			int32_t acc = (int32_t)c.b0 * v[ch];
+			acc = addSat(acc, (int32_t)c.b1 * i1[ch]);
+			acc = addSat(acc, (int32_t)c.b2 * i2[ch]);
+			acc = addSat(acc, -((int32_t)c.a1 * o1[ch]));
+			acc = addSat(acc, -((int32_t)c.a2 * o2[ch]));
+			acc = addSat(acc, r[ch]);
+#else
+			int64_t acc = (int64_t)((int32_t)c.b0 * v[ch])
+			            + (int64_t)((int32_t)c.b1 * i1[ch])
+			            + (int64_t)((int32_t)c.b2 * i2[ch])
+			            - (int64_t)((int32_t)c.a1 * o1[ch])
+			            - (int64_t)((int32_t)c.a2 * o2[ch])
+			            + r[ch];
+#endif
+			r[ch] = (int16_t)(acc & ((1L << BIQUAD_SHIFT) - 1));
+			acc >>= BIQUAD_SHIFT;
+			if( acc > 32767 ) {
+				acc = 32767;
+			} else if( acc < -32768 ) {
+				acc = -32768;
+			}
+
+			i2[ch] = i1[ch];
+			i1[ch] = v[ch];
+			o2[ch] = o1[ch];
+			o1[ch] = (int16_t)acc;
+			v[ch] = (int16_t)acc;
+		}
+	}
+
+	memcpy(out, v, channels * sizeof(int16_t));
+}
+
+/************************************************************************/
+/* Second order Butterworth (q 0.7071) low-pass at cutoffHz for samples */
+/* arriving at odrHz. Cutoffs much below ODR / 100 lose precision in    */
+/* b0, though the DC gain is kept at exactly 1.                         */
+/************************************************************************/
+void BiquadBank::lowPass(biquad_t *section, float odrHz, float cutoffHz, float q)
+{
+	float w0 = 2 * PI * cutoffHz / odrHz;
+	float cosw = cos(w0);
+	float alpha = sin(w0) / (2 * q);
+
+	design(section, (1 - cosw) / 2, (1 - cosw) / 2, 1 + alpha, -2 * cosw, 1 - alpha);
+}
+
+/************************************************************************/
+/* Notch at centreHz, e.g. for motor or mains pickup. Higher q narrows  */
+/* the notch.                                                           */
+/************************************************************************/
+void BiquadBank::notch(biquad_t *section, float odrHz, float centreHz, float q)
+{
+	float w0 = 2 * PI * centreHz / odrHz;
+	float cosw = cos(w0);
+	float alpha = sin(w0) / (2 * q);
+
+	design(section, 1, 1, 1 + alpha, -2 * cosw, 1 - alpha);
+}
+
+/************************************************************************/
+/* Normalise by a0 and quantise to Q14. Only for designs with unity DC  */
+/* gain, b0 + b1 + b2 = a0 + a1 + a2: b1 is not passed in but solved    */
+/* from that after rounding, so the quantised section keeps it exactly. */
+/************************************************************************/
+void BiquadBank::design(biquad_t *section, float b0, float b2,
+                        float a0, float a1, float a2)
+{
+	section->b0 = quantise(b0 / a0);
+	section->b2 = quantise(b2 / a0);
+	section->a1 = quantise(a1 / a0);
+	section->a2 = quantise(a2 / a0);
+
+	int32_t dc = (1L << BIQUAD_SHIFT) + section->a1 + section->a2 - section->b0 - section->b2;
+	section->b1 = (int16_t)constrain(dc, -32768L, 32767L);
+}
+
+/************************************************************************/
+/*                                                                      */
+/************************************************************************/
+int16_t BiquadBank::quantise(float value)
+{
+	float scaled = value * (1L << BIQUAD_SHIFT);
+	scaled += scaled < 0 ? -0.5F : 0.5F;
+	return (int16_t)constrain(scaled, -32768.0F, 32767.0F);
+}
+
+#ifdef BIQUAD_SATURATING
+/************************************************************************/
+/* a + b, clamped to the int32_t range rather than wrapping             */
+/************************************************************************/
+int32_t BiquadBank::addSat(int32_t a, int32_t b)
+{
+	int32_t r = (int32_t)((uint32_t)a + (uint32_t)b);
+
+	if( ((a ^ r) & (b ^ r)) < 0 ) {
+		r = a < 0 ? (-0x7FFFFFFFL - 1) : 0x7FFFFFFFL;
+	}
+	return r;
+}
+#endif
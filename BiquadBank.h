@@ -0,0 +1,87 @@
+/*
+Header file for the fixed-point biquad filter bank.
+Copyright (C) 2013-2026 G.Pimblott and contributors
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the version 3 GNU General Public License as
+published by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef BIQUADBANK_H_
+#define BIQUADBANK_H_
+
+#include "Arduino.h"
+
+#define BIQUAD_MAX_CHANNELS 9     /* e.g. three 3-axis sensors */
+#define BIQUAD_MAX_SECTIONS 2
+#define BIQUAD_SHIFT        14    /* coefficients are Q14, -2.0 .. 2.0 */
+
+/* 32-bit saturating accumulator on AVR, 64-bit everywhere else */
+#if defined(__AVR__)
+#define BIQUAD_SATURATING
+#endif
+
+/** One second order section, a0 normalised to 1 */
+typedef struct
+{
+	int16_t b0, b1, b2;
+	int16_t a1, a2;
+} biquad_t;
+
+/************************************************************************/
+/* Cascaded biquad sections run over several channels in lock step,     */
+/* such as the axes of one or more sensors sampled at the same rate.    */
+/* Samples are the drivers' raw counts; every channel shares the        */
+/* sections' coefficients and has its own state.                        */
+/*                                                                      */
+/* Each section is Direct Form I with 16-bit state, so the only wide    */
+/* value is the accumulator. On AVR that is 32 bits and saturates at    */
+/* every add. Elsewhere it is 64 bits, wide enough never to overflow.   */
+/* The state is laid out channel-innermost. Outputs clip to 16 bits on  */
+/* both. The bits shifted off each output are added back into the next  */
+/* (error feedback) rather than discarded.                              */
+/************************************************************************/
+class BiquadBank {
+	public:
+	BiquadBank(uint8_t channels);
+
+	// Coefficient design, RBJ cookbook, floating point at setup only
+	static void lowPass(biquad_t *section, float odrHz, float cutoffHz, float q = 0.7071F);
+	static void notch(biquad_t *section, float odrHz, float centreHz, float q = 2.0F);
+
+	bool addSection(const biquad_t *section);
+	void reset();
+	void process(int16_t *samples);
+	void process(const int16_t *in, int16_t *out);
+
+	uint8_t size() { return channels; };
+	uint8_t depth() { return sections; };
+
+	private:
+	static void design(biquad_t *section, float b0, float b2,
+	                   float a0, float a1, float a2);
+	static int16_t quantise(float value);
+#ifdef BIQUAD_SATURATING
+	static int32_t addSat(int32_t a, int32_t b);
+#endif
+
+	uint8_t channels;
+	uint8_t sections;
+	biquad_t coeffs[BIQUAD_MAX_SECTIONS];
+	int16_t in1[BIQUAD_MAX_SECTIONS][BIQUAD_MAX_CHANNELS];   /* x[n-1] */
+	int16_t in2[BIQUAD_MAX_SECTIONS][BIQUAD_MAX_CHANNELS];   /* x[n-2] */
+	int16_t out1[BIQUAD_MAX_SECTIONS][BIQUAD_MAX_CHANNELS];  /* y[n-1] */
+	int16_t out2[BIQUAD_MAX_SECTIONS][BIQUAD_MAX_CHANNELS];  /* y[n-2] */
+	int16_t residue[BIQUAD_MAX_SECTIONS][BIQUAD_MAX_CHANNELS];  /* bits shifted off y[n-1] */
+};
+
+#endif /* BIQUADBANK_H_ */
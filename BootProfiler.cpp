@@ -0,0 +1,98 @@
+/*
+Boot profiler.
+Copyright (C) 2013-2026 G.Pimblott and contributors
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the version 3 GNU General Public License as
+published by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include "BootProfiler.h"
+
+/************************************************************************/
+/*                                                                      */
+/************************************************************************/
+BootProfiler::BootProfiler()
+{
+#ifdef BOOT_PROFILE
+	count = 0;
+	started = 0;
+	last = 0;
+#endif
+	readyAt = 0;
+}
+
+/************************************************************************/
+/* A device needs ms from now before it can be used                     */
+/************************************************************************/
+void BootProfiler::settle(uint16_t ms)
+{
+	uint32_t ready = micros() + (uint32_t)ms * 1000;
+
+	if( (int32_t)(ready - readyAt) > 0 ) {
+		readyAt = ready;
+	}
+}
+
+/************************************************************************/
+/* Wait until every device passed to settle() is ready                  */
+/************************************************************************/
+void BootProfiler::waitSettled()
+{
+	while( (int32_t)(readyAt - micros()) > 0 ) {
+	}
+}
+
+#ifdef BOOT_PROFILE
+/************************************************************************/
+/* Start timing, call first thing in setup()                            */
+/************************************************************************/
+void BootProfiler::begin()
+{
+	count = 0;
+	started = micros();
+	last = started;
+	readyAt = started;
+}
+
+/************************************************************************/
+/* Record the time since the previous mark against a phase name. The    */
+/* name is not copied so must be a literal or otherwise stay valid.     */
+/************************************************************************/
+void BootProfiler::mark(const char *phase)
+{
+	uint32_t now = micros();
+
+	if( count < BOOT_PROFILER_MAX ) {
+		names[count] = phase;
+		durations[count] = now - last;
+		count++;
+	}
+	last = now;
+}
+
+/************************************************************************/
+/* Print each phase in microseconds followed by the total               */
+/************************************************************************/
+void BootProfiler::report(Print *out)
+{
+	for(uint8_t i = 0; i < count; i++) {
+		out->print("Boot ");
+		out->print(names[i]);
+		out->print(": ");
+		out->print(durations[i]);
+		out->println(" us");
+	}
+	out->print("Boot total: ");
+	out->print(total());
+	out->println(" us");
+}
+#endif
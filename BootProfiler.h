@@ -0,0 +1,67 @@
+/*
+Header file for the boot profiler.
+Copyright (C) 2013-2026 G.Pimblott and contributors
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the version 3 GNU General Public License as
+published by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef BOOTPROFILER_H_
+#define BOOTPROFILER_H_
+
+#include "Arduino.h"
+
+/* Uncomment to time each phase of setup(), see BootProfiler::report(). */
+/* Costs about 60 bytes of RAM, settling works either way.              */
+//#define BOOT_PROFILE
+
+#define BOOT_PROFILER_MAX 8
+
+/************************************************************************/
+/* Tracks device settling times and, with BOOT_PROFILE, times each      */
+/* phase of start-up.                                                   */
+/*                                                                      */
+/* Rather than each sensor waiting for its own power-up time in turn,   */
+/* settle() records when each device will be ready and waitSettled()    */
+/* waits once for the last of them, so the settling times overlap.      */
+/************************************************************************/
+class BootProfiler {
+	public:
+	BootProfiler();
+
+	void settle(uint16_t ms);
+	void waitSettled();
+
+#ifdef BOOT_PROFILE
+	void begin();
+	void mark(const char *phase);
+
+	uint32_t total() { return last - started; };
+	void report(Print *out);
+#else
+	void begin() {};
+	void mark(const char *) {};
+#endif
+
+	private:
+#ifdef BOOT_PROFILE
+	const char *names[BOOT_PROFILER_MAX];
+	uint32_t durations[BOOT_PROFILER_MAX];
+	uint8_t count;
+	uint32_t started;
+	uint32_t last;
+#endif
+	uint32_t readyAt;
+};
+
+#endif /* BOOTPROFILER_H_ */
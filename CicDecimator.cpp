@@ -0,0 +1,120 @@
+/*
+CIC decimator.
+Copyright (C) 2013-2026 G.Pimblott and contributors
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the version 3 GNU General Public License as
+published by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include "CicDecimator.h"
+
+/* Compensation taps, Q8, by order, each the least worst passband error */
+/* up to a quarter of the output rate at ratio 8 */
+static const int16_t compensation[CIC_MAX_ORDER] = { 13, 28, 43 };
+
+/************************************************************************/
+/*                                                                      */
+/************************************************************************/
+CicDecimator::CicDecimator(uint8_t ratio, uint8_t order, bool compensate)
+{
+	configure(ratio, order, compensate);
+}
+
+/************************************************************************/
+/* ratio 1 to CIC_MAX_RATIO, order 1 to CIC_MAX_ORDER. Resets the state.*/
+/************************************************************************/
+void CicDecimator::configure(uint8_t ratio, uint8_t order, bool compensate)
+{
+	this->ratio = constrain(ratio, 1, CIC_MAX_RATIO);
+	this->order = constrain(order, 1, CIC_MAX_ORDER);
+
+	divisor = 1;
+	for(uint8_t i = 0; i < this->order; i++) {
+		divisor *= this->ratio;
+	}
+
+	shift = 0;
+	if( (this->ratio & (this->ratio - 1)) == 0 ) {
+		while( (1L << shift) < divisor ) {
+			shift++;
+		}
+	}
+
+	alpha = compensate && this->ratio > 1 ? compensation[this->order - 1] : 0;
+	reset();
+}
+
+/************************************************************************/
+/*                                                                      */
+/************************************************************************/
+void CicDecimator::reset()
+{
+	phase = 0;
+
+	/* An order N CIC spans N outputs, the FIR then needs two more */
+	primed = order - 1 + (alpha ? 2 : 0);
+	memset(integrator, 0, sizeof(integrator));
+	memset(comb, 0, sizeof(comb));
+	memset(history, 0, sizeof(history));
+}
+
+/************************************************************************/
+/* Feed one input sample per channel. Every ratio-th call fills out and */
+/* returns true. The outputs are held back until the filter has filled, */
+/* order - 1 of them, plus 2 with the compensation.                     */
+/************************************************************************/
+bool CicDecimator::push(const int16_t *in, int16_t *out)
+{
+	for(uint8_t ch = 0; ch < CIC_CHANNELS; ch++) {
+		uint32_t value = (uint32_t)(int32_t)in[ch];
+		for(uint8_t i = 0; i < order; i++) {
+			integrator[i][ch] += value;
+			value = integrator[i][ch];
+		}
+	}
+
+	if( ++phase < ratio ) {
+		return false;
+	}
+	phase = 0;
+
+	for(uint8_t ch = 0; ch < CIC_CHANNELS; ch++) {
+		uint32_t value = integrator[order - 1][ch];
+		for(uint8_t i = 0; i < order; i++) {
+			uint32_t previous = comb[i][ch];
+			comb[i][ch] = value;
+			value -= previous;
+		}
+
+		// The combs leave a true sum, only the integrators wrapped
+		int32_t sum = (int32_t)value;
+		int16_t sample = (int16_t)(shift ? sum >> shift : sum / divisor);
+
+		if( alpha ) {
+			// Centre tap 1 + 2 alpha, outer taps -alpha
+			int32_t fir = (int32_t)history[0][ch] * (256 + 2 * alpha)
+			            - ((int32_t)sample + history[1][ch]) * alpha;
+			history[1][ch] = history[0][ch];
+			history[0][ch] = sample;
+			fir >>= 8;
+			out[ch] = (int16_t)constrain(fir, -32768L, 32767L);
+		} else {
+			out[ch] = sample;
+		}
+	}
+
+	if( primed ) {
+		primed--;
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,67 @@
+/*
+Header file for the CIC decimator.
+Copyright (C) 2013-2026 G.Pimblott and contributors
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the version 3 GNU General Public License as
+published by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef CICDECIMATOR_H_
+#define CICDECIMATOR_H_
+
+#include "Arduino.h"
+
+#define CIC_CHANNELS  3     /* one 3-axis sensor */
+#define CIC_MAX_ORDER 3
+#define CIC_MAX_RATIO 32    /* 16 bits + 3 x 5 bits of growth fits 32 */
+
+/************************************************************************/
+/* Cuts a high sample rate down to an output rate with anti-aliasing,   */
+/* using only adds at the input rate.                                   */
+/*                                                                      */
+/* order integrators run at the input rate and order combs at the       */
+/* output rate; order 1 is a plain boxcar average of ratio samples.     */
+/* The integrators wrap in 32 bits, which the combs undo exactly. The   */
+/* output is scaled back by ratio^order, a shift when ratio is a power  */
+/* of two.                                                              */
+/*                                                                      */
+/* The optional compensation is a 3-tap FIR at the output rate that     */
+/* lifts the CIC's passband droop, flat to within 3% up to a quarter    */
+/* of the output rate for ratios of 4 and up, at the cost of one output */
+/* sample of delay. test/CicDecimatorTest.cpp checks this.              */
+/************************************************************************/
+class CicDecimator {
+	public:
+	CicDecimator(uint8_t ratio = 8, uint8_t order = 3, bool compensate = true);
+
+	void configure(uint8_t ratio, uint8_t order, bool compensate);
+	void reset();
+	bool push(const int16_t *in, int16_t *out);
+
+	uint8_t getRatio() { return ratio; };
+	uint8_t getOrder() { return order; };
+
+	private:
+	uint8_t ratio;
+	uint8_t order;
+	uint8_t shift;          /* log2(ratio^order), or 0 to divide */
+	int32_t divisor;
+	int16_t alpha;          /* compensation tap, Q8, 0 for none */
+	uint8_t phase;
+	uint8_t primed;         /* outputs until the combs and FIR are full */
+	uint32_t integrator[CIC_MAX_ORDER][CIC_CHANNELS];
+	uint32_t comb[CIC_MAX_ORDER][CIC_CHANNELS];
+	int16_t history[2][CIC_CHANNELS];
+};
+
+#endif /* CICDECIMATOR_H_ */
@@ -0,0 +1,153 @@
+/*
+Driver benchmarks.
+Copyright (C) 2013-2026 G.Pimblott and contributors
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the version 3 GNU General Public License as
+published by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include "DriverBenchmark.h"
+#include "Benchmark.h"
+#include "SensorBus.h"
+#include "L3G4200D.h"
+#include "ADXL345.h"
+#include "HMC5883L.h"
+#include "BMP085.h"
+#include "BMP085Sampler.h"
+
+#define BENCHMARK_CALLS 200
+#define BENCHMARK_MATH_CALLS 1000
+#define BENCHMARK_CONVERSION_CALLS 5  /* BMP085 reads wait for real conversions */
+
+/* Datasheet example calibration, big endian from 0xAA, and UT = 27898 */
+static const uint8_t bmp085Calibration[22] = {
+	0x01, 0x98, 0xFF, 0xB8, 0xC7, 0xD1, 0x7F, 0xE5, 0x7F, 0xF5, 0x5A, 0x71,
+	0x18, 0x2E, 0x00, 0x04, 0x80, 0x00, 0xDD, 0xF9, 0x0B, 0x34
+};
+
+/* The drivers under test, only valid during runDriverBenchmarks() */
+static L3G4200D *gyro;
+static ADXL345 *accel;
+static HMC5883L *compass;
+static BMP085 *barometer;
+static BMP085Sampler *sampler;
+static L3G4200D::vector v1, v2, v3;
+
+/* Results are written here so the work can't be optimised away */
+static volatile float sink;
+
+/************************************************************************/
+/* BMP085 conversion time for a control register command                */
+/************************************************************************/
+static uint32_t bmp085Conversion(uint8_t command)
+{
+	if( command == BMP085_REGISTER_READTEMPCMD ) {
+		return BMP085::conversionMicros(BMP085_CONVERSION_TEMPERATURE);
+	}
+	return BMP085::conversionMicros(command >> 6);
+}
+
+/************************************************************************/
+/* Load the datasheet calibration and a UT reading into a simulated     */
+/* BMP085 that takes as long as the real part to convert                */
+/************************************************************************/
+static void simulateBarometer(SimulatedBus *bus)
+{
+	for(uint8_t i = 0; i < sizeof(bmp085Calibration); i++) {
+		bus->poke(BMP085_REGISTER_CAL_AC1 + i, bmp085Calibration[i]);
+	}
+	bus->poke(BMP085_REGISTER_CHIPID, BMP085_CHIPID);
+	bus->poke(BMP085_REGISTER_TEMPDATA, 0x6C);
+	bus->poke(BMP085_REGISTER_TEMPDATA + 1, 0xFA);
+	bus->setConversion(BMP085_REGISTER_CONTROL, bmp085Conversion);
+}
+
+static void benchGyroRead() { gyro->read(); }
+static void benchAccelRead() { int xyz[3]; accel->readAccel(xyz); sink = xyz[0]; }
+static void benchAccelGxyz() { double xyz[3]; accel->get_Gxyz(xyz); sink = xyz[0]; }
+static void benchCompassEvent() { sensors_event_t e; compass->getEvent(&e); sink = e.magnetic.x; }
+static void benchBarometerEvent() { sensors_event_t e; barometer->getEvent(&e); sink = e.pressure; }
+static void benchBarometerPressure() { float p; barometer->getPressure(&p); sink = p; }
+static void benchBarometerTemperature() { float t; barometer->getTemperature(&t); sink = t; }
+static void benchSampler() { sampler->sample(); sink = sampler->getPressurePa(1); }
+static void benchCompensate() { sink = barometer->compensatePressure(27898, 23843); }
+static void benchCompensateTemperature() { sink = barometer->compensateTemperature(27898); }
+static void benchHeading() { sink = HMC5883L::heading(v1.x, v1.y, 0.0457F); }
+static void benchAltitude() { sink = barometer->pressureToAltitude(1013.25F, 995.0F, 15.0F); }
+static void benchNormalize() { v3 = v1; L3G4200D::vector_normalize(&v3); }
+static void benchDot() { sink = L3G4200D::vector_dot(&v1, &v2); }
+static void benchCross() { L3G4200D::vector_cross(&v1, &v2, &v3); }
+
+/************************************************************************/
+/* Every driver shares one simulated bus, the register maps overlap but */
+/* only the BMP085 needs meaningful contents. A second barometer on its */
+/* own bus stands in for the one a real board can't address (both are  */
+/* fixed at 0x77) so the pipelined sampler has two devices to overlap.  */
+/* Each bus holds a 256 byte register file, so they are static rather   */
+/* than on the stack, which the sketch's globals leave little of on an  */
+/* ATmega328. They are only linked in with DRIVER_BENCHMARK.            */
+/************************************************************************/
+void runDriverBenchmarks(Print *out)
+{
+	static SimulatedBus bus(SimulatedBus::TRANSPORT_I2C, SENSOR_I2C_CLOCK_FAST);
+	static SimulatedBus secondBus(SimulatedBus::TRANSPORT_I2C, SENSOR_I2C_CLOCK_FAST);
+	L3G4200D simGyro;
+	ADXL345 simAccel;
+	HMC5883L simCompass;
+	BMP085 simBarometer;
+	BMP085 secondBarometer;
+	BMP085 *barometers[2] = { &simBarometer, &secondBarometer };
+	BMP085Sampler simSampler(barometers, 2);
+	Benchmark bench(out);
+
+	bus.resetTiming();
+	secondBus.resetTiming();
+	simulateBarometer(&bus);
+	simulateBarometer(&secondBus);
+
+	simGyro.setBus(&bus);
+	simAccel.setBus(&bus);
+	simCompass.setBus(&bus);
+	simBarometer.setBus(&bus);
+	simBarometer.begin(BMP085_MODE_ULTRALOWPOWER);
+	secondBarometer.setBus(&secondBus);
+	secondBarometer.begin(BMP085_MODE_ULTRALOWPOWER);
+
+	gyro = &simGyro;
+	accel = &simAccel;
+	compass = &simCompass;
+	barometer = &simBarometer;
+	sampler = &simSampler;
+	v1.x = 0.3F; v1.y = -1.2F; v1.z = 9.7F;
+	v2.x = 1.1F; v2.y = 0.4F; v2.z = -0.2F;
+
+	bench.begin();
+	bench.run("L3G4200D::read", benchGyroRead, BENCHMARK_CALLS);
+	bench.run("ADXL345::readAccel", benchAccelRead, BENCHMARK_CALLS);
+	bench.run("ADXL345::get_Gxyz", benchAccelGxyz, BENCHMARK_CALLS);
+	bench.run("HMC5883L::getEvent", benchCompassEvent, BENCHMARK_CALLS);
+	bench.run("BMP085::getEvent", benchBarometerEvent, BENCHMARK_CONVERSION_CALLS);
+	bench.run("BMP085::getPressure", benchBarometerPressure, BENCHMARK_CONVERSION_CALLS);
+	bench.run("BMP085::getTemperature", benchBarometerTemperature, BENCHMARK_CONVERSION_CALLS);
+	bench.run("BMP085Sampler::sample x2", benchSampler, BENCHMARK_CONVERSION_CALLS);
+	bench.run("BMP085::compensatePressure", benchCompensate, BENCHMARK_MATH_CALLS);
+	bench.run("BMP085::compensateTemperature", benchCompensateTemperature, BENCHMARK_MATH_CALLS);
+	bench.run("HMC5883L::heading", benchHeading, BENCHMARK_MATH_CALLS);
+	bench.run("BMP085::pressureToAltitude", benchAltitude, BENCHMARK_MATH_CALLS);
+	bench.run("L3G4200D::vector_normalize", benchNormalize, BENCHMARK_MATH_CALLS);
+	bench.run("L3G4200D::vector_dot", benchDot, BENCHMARK_MATH_CALLS);
+	bench.run("L3G4200D::vector_cross", benchCross, BENCHMARK_MATH_CALLS);
+
+	/* Any BMP085 result read before its conversion time was up */
+	out->print("BMP085 early reads,");
+	out->println(bus.earlyReads() + secondBus.earlyReads());
+}
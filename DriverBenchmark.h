@@ -0,0 +1,34 @@
+/*
+Header file for the driver benchmarks.
+Copyright (C) 2013-2026 G.Pimblott and contributors
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the version 3 GNU General Public License as
+published by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef DRIVERBENCHMARK_H_
+#define DRIVERBENCHMARK_H_
+
+#include "Arduino.h"
+
+/************************************************************************/
+/* Time the driver hot paths against a simulated bus and print the      */
+/* results as CSV. No sensors need to be connected; the drivers are     */
+/* created for the run and released afterwards. It is meant to run on   */
+/* the target board, from setup() with DRIVER_BENCHMARK in IMU.ino,     */
+/* where the cycle columns are exact counts at the CPU clock. There is  */
+/* no host build of it.                                                 */
+/************************************************************************/
+void runDriverBenchmarks(Print *out);
+
+#endif /* DRIVERBENCHMARK_H_ */
@@ -26,7 +26,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 bool HMC5883L::begin()
 {
 	// Enable I2C
-	Wire.begin();
+	bus->begin();
 
 	/* Make sure we have the right device */
 	uint8_t id1,id2,id3;
@@ -65,11 +65,11 @@ void HMC5883L::getSensor(sensor_t *sensor)
 }
 
 /**************************************************************************/
-/* Get the next reading from the sensor                                   */
+/* Get the next reading from the sensor, returns the bus status           */
 /**************************************************************************/
-void HMC5883L::getEvent(sensors_event_t *event)
+uint8_t HMC5883L::getEvent(sensors_event_t *event)
 {
-	float pressure_kPa;
+	uint32_t started = micros();
 
 	/* Clear the event */
 	memset(event, 0, sizeof(sensors_event_t));
@@ -77,15 +77,36 @@ void HMC5883L::getEvent(sensors_event_t *event)
 	event->version   = sizeof(sensors_event_t);
 	event->sensor_id = deviceId;
 	event->type      = SENSOR_TYPE_MAGNETIC_FIELD;
-	event->timestamp = 0;
-	
 	
 	// Retrived the scaled values from the compass (scaled to the configured scale).
+	bus->clearError();
 	MagnetometerScaled scaled = ReadScaledAxis();
 	
 	event->orientation.x = scaled.XAxis;
 	event->orientation.y = scaled.YAxis;
 	event->orientation.z = scaled.ZAxis;
+	stampEvent(event, started);
+	return eventStatus();
+}
+
+/************************************************************************/
+/*  Heading in radians (0..2PI) of a level magnetometer reading, with   */
+/*  the local declination in radians added                              */
+/************************************************************************/
+float HMC5883L::heading(float x, float y, float declination)
+{
+	float heading = atan2(y, x) + declination;
+
+	// Correct for when signs are reversed.
+	if(heading < 0) {
+		heading += 2*PI;
+	}
+
+	// Check for wrap due to addition of declination.
+	if(heading > 2*PI) {
+		heading -= 2*PI;
+	}
+	return heading;
 }
 
 /************************************************************************/
@@ -93,7 +114,12 @@ void HMC5883L::getEvent(sensors_event_t *event)
 /************************************************************************/
 MagnetometerRaw HMC5883L::ReadRawAxis()
 {
-	uint8_t* buffer = Read(DataRegisterBegin, 6);
+	// In new-data-only mode the last sample is decoded again when RDY is
+	// clear. The HMC5883L has no overrun flag so overruns are not counted.
+	uint8_t* buffer = m_Buffer;
+	if( checkNewData(StatusRegister, Status_Ready, 0) == SENSOR_BUS_OK ) {
+		buffer = Read(DataRegisterBegin, 6);
+	}
 	MagnetometerRaw raw = MagnetometerRaw();
 	raw.XAxis = (buffer[0] << 8) | buffer[1];
 	raw.ZAxis = (buffer[2] << 8) | buffer[3];
@@ -166,6 +192,7 @@ int HMC5883L::SetScale(float gauss)
 	// Setting is in the top 3 bits of the register.
 	regValue = regValue << 5;
 	writeCommand(ConfigurationRegisterB, regValue);
+	return 0;
 }
 
 /************************************************************************/
@@ -183,22 +210,14 @@ int HMC5883L::SetMeasurementMode(uint8_t mode)
 /************************************************************************/
 uint8_t* HMC5883L::Read(int address, int length)
 {
-	writeI2C( address );
-	
-	Wire.beginTransmission(HMC5883L_Address);
-	Wire.requestFrom(HMC5883L_Address, length);
-
-	uint8_t buffer[length];
-	if(Wire.available() == length)
+	if(length > (int)sizeof(m_Buffer))
 	{
-		for(uint8_t i = 0; i < length; i++)
-		{
-			buffer[i] = Wire.read();
-		}
+		length = sizeof(m_Buffer);
 	}
-	Wire.endTransmission();
 
-	return buffer;
+	readBytes(address, m_Buffer, length);
+
+	return m_Buffer;
 }
 
 char* HMC5883L::GetErrorText(int errorCode)
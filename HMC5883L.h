@@ -29,6 +29,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #define HMC5883L_Address 0x1E
 #define HMC5883L_DEV_ID 0x483433
+#define HMC5883L_MAX_I2C_CLOCK 400000L
+#define HMC5883L_STARTUP_MS 67   // first continuous measurement at the default 15Hz
 
 #define ConfigurationRegisterA 0x00
 #define ConfigurationRegisterB 0x01
@@ -38,6 +40,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #define ModeRegister 0x02
 #define DataRegisterBegin 0x03
+#define StatusRegister 0x09
+
+#define Status_Ready 0x01
 
 #define Measurement_Continuous 0x00
 #define Measurement_SingleShot 0x01
@@ -63,8 +68,10 @@ struct MagnetometerRaw
 class HMC5883L : public Sensor
 {
 	public:
-	  HMC5883L() : Sensor(HMC5883L_Address , 1000084) {
+	  HMC5883L(int32_t sensorID = 1000084) : Sensor(HMC5883L_Address , sensorID) {
 		m_Scale = 1;
+		memset(m_Buffer, 0, sizeof(m_Buffer));
+		i2c.setMaxClock(HMC5883L_MAX_I2C_CLOCK);
 		}  ;
 		
 	  bool begin();
@@ -76,8 +83,10 @@ class HMC5883L : public Sensor
 	  int SetScale(float gauss);
 
 	  char* GetErrorText(int errorCode);
+
+	  static float heading(float x, float y, float declination);
 	  
-	  void  getEvent(sensors_event_t*);
+	  uint8_t getEvent(sensors_event_t*);
 	  void  getSensor(sensor_t*);
 
 	protected:
@@ -86,5 +95,6 @@ class HMC5883L : public Sensor
 
 	private:
 	  float m_Scale;
+	  uint8_t m_Buffer[6];
 };
 #endif
\ No newline at end of file
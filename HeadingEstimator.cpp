@@ -0,0 +1,143 @@
+/*
+Gyro aided heading estimator.
+Copyright (C) 2013-2026 G.Pimblott and contributors
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the version 3 GNU General Public License as
+published by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include "HeadingEstimator.h"
+
+/************************************************************************/
+/* gainShift sets the compass correction gain to 1 / 2^gainShift       */
+/************************************************************************/
+HeadingEstimator::HeadingEstimator(uint8_t gainShift)
+{
+	angle = 0;
+	scale = 0;
+	reversed = false;
+	declination = 0;
+	shift = gainShift;
+	error = 0;
+	valid = false;
+	timed = false;
+	lastSample = 0;
+}
+
+/************************************************************************/
+/* Gyro sensitivity, e.g. L3G4200D_SENSITIVITY_250DPS. With the gyro Z  */
+/* axis up a positive rate turns atan2(y, x) of the field backwards, so */
+/* pass a negative value when the sensors are mounted that way.         */
+/************************************************************************/
+void HeadingEstimator::setGyroScale(float dpsPerCount)
+{
+	reversed = dpsPerCount < 0;
+	if( reversed ) {
+		dpsPerCount = -dpsPerCount;
+	}
+
+	// 2^32 / 360 binary angle per degree, 1e-6 seconds per microsecond
+	// and 2^14 for the fraction: 2000dps still fits 16 bits
+	scale = (uint16_t)(dpsPerCount * (4294967296.0F / 360.0F) * 1e-6F * 16384.0F + 0.5F);
+}
+
+/************************************************************************/
+/*                                                                      */
+/************************************************************************/
+void HeadingEstimator::setDeclination(float radians)
+{
+	declination = (uint16_t)(int16_t)(radians * (65536.0F / (2 * PI)));
+}
+
+/************************************************************************/
+/* Carry the heading forward by a gyro rate, in counts, over dtMicros.  */
+/* dt times scale fits 32 bits, and the product with the rate is taken  */
+/* modulo 2^32, which is exactly the binary angle wrap-around.          */
+/************************************************************************/
+void HeadingEstimator::propagate(int16_t rate, uint32_t dtMicros)
+{
+	if( dtMicros > HEADING_MAX_DT ) {
+		dtMicros = HEADING_MAX_DT;
+	}
+
+	uint32_t perCount = (dtMicros * scale + (1UL << 13)) >> 14;
+	int32_t counts = reversed ? -(int32_t)rate : rate;
+
+	angle += (uint32_t)counts * perCount;
+}
+
+/************************************************************************/
+/* As propagate(), timing the step from the previous call's sample time */
+/************************************************************************/
+void HeadingEstimator::update(int16_t rate, uint32_t sampleMicros)
+{
+	if( timed ) {
+		propagate(rate, sampleMicros - lastSample);
+	}
+	lastSample = sampleMicros;
+	timed = true;
+}
+
+/************************************************************************/
+/* Pull the heading towards a compass reading, in any units as long as  */
+/* x and y share them. The first reading sets the heading outright.     */
+/************************************************************************/
+void HeadingEstimator::correct(int16_t x, int16_t y)
+{
+	uint32_t target = (uint32_t)(uint16_t)(atan2Bam(y, x) + declination) << 16;
+
+	if( !valid ) {
+		angle = target;
+		error = 0;
+		valid = true;
+		return;
+	}
+
+	int32_t difference = (int32_t)(target - angle);
+	error = (int16_t)(difference >> 16);
+	angle += (uint32_t)(difference >> shift);
+}
+
+/************************************************************************/
+/* atan2 as a 16-bit binary angle, 0..65535 for 0..2PI, error under     */
+/* 0.1 degree. The ratio of the smaller to the larger component is      */
+/* taken in Q15 and fed through                                         */
+/*   atan(z) = PI/4 z - z (z - 1)(0.2447 + 0.0663 z)                    */
+/* before being unfolded into the right octant.                         */
+/************************************************************************/
+uint16_t HeadingEstimator::atan2Bam(int16_t y, int16_t x)
+{
+	uint16_t ax = x < 0 ? -(int32_t)x : x;
+	uint16_t ay = y < 0 ? -(int32_t)y : y;
+
+	if( ax == 0 && ay == 0 ) {
+		return 0;
+	}
+
+	bool steep = ay > ax;
+	uint32_t z = steep ? ((uint32_t)ax << 15) / ay : ((uint32_t)ay << 15) / ax;
+
+	// 8192 is PI/4, 2552 and 691 are 0.2447 and 0.0663 radians
+	uint32_t bend = (z * (32768 - z)) >> 15;
+	uint16_t a = (z >> 2) + ((bend * (2552 + ((691 * z) >> 15))) >> 15);
+
+	if( steep ) {
+		a = 16384 - a;
+	}
+	if( x < 0 ) {
+		a = 32768 - a;
+	}
+	if( y < 0 ) {
+		a = -a;
+	}
+	return a;
+}
@@ -0,0 +1,71 @@
+/*
+Header file for the gyro aided heading estimator.
+Copyright (C) 2013-2026 G.Pimblott and contributors
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the version 3 GNU General Public License as
+published by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef HEADINGESTIMATOR_H_
+#define HEADINGESTIMATOR_H_
+
+#include "Arduino.h"
+
+/* Longest gyro interval propagated in one step, longer gaps are clipped */
+/* and left for the compass to correct                                  */
+#define HEADING_MAX_DT      262143L
+#define HEADING_GAIN_SHIFT  4         /* compass correction gain of 1/16 */
+
+/************************************************************************/
+/* Heading at the gyro's rate, held to the compass's long term accuracy.*/
+/*                                                                      */
+/* Between compass samples the heading is carried forward by the gyro   */
+/* Z rate; each compass sample then pulls it a fraction of the way      */
+/* towards the magnetic heading. All the per-sample work is 32-bit      */
+/* integer arithmetic. Angles are binary angles, a full turn being 2^32 */
+/* internally and 2^16 from heading(), so wrap-around is free.          */
+/*                                                                      */
+/* Headings follow HMC5883L::heading(), atan2(y, x) plus declination.   */
+/************************************************************************/
+class HeadingEstimator {
+	public:
+	HeadingEstimator(uint8_t gainShift = HEADING_GAIN_SHIFT);
+
+	// Configuration, may use floating point
+	void setGyroScale(float dpsPerCount);
+	void setDeclination(float radians);
+
+	void propagate(int16_t rate, uint32_t dtMicros);
+	void update(int16_t rate, uint32_t sampleMicros);
+	void correct(int16_t x, int16_t y);
+
+	bool isValid() { return valid; };
+	uint16_t heading() { return angle >> 16; };
+	int16_t lastError() { return error; };
+	float radians() { return heading() * (2 * PI / 65536.0F); };
+
+	static uint16_t atan2Bam(int16_t y, int16_t x);
+
+	private:
+	uint32_t angle;
+	uint16_t scale;        /* binary angle per count-microsecond, Q14 */
+	bool reversed;         /* gyro turns the opposite way to the heading */
+	uint16_t declination;
+	uint8_t shift;
+	int16_t error;         /* last compass minus estimate, binary angle */
+	bool valid;
+	bool timed;
+	uint32_t lastSample;
+};
+
+#endif /* HEADINGESTIMATOR_H_ */
@@ -17,21 +17,116 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 */
 #include <Wire.h>
+#include <SPI.h>
+#include <EEPROM.h>
+#include "BootProfiler.h"
+#include "SensorTrace.h"
+#include "SensorAlign.h"
+#include "HeadingEstimator.h"
+#include "VerticalKalman.h"
+#include "BiquadBank.h"
+#include "CicDecimator.h"
+#include "DriverBenchmark.h"
+#include "L3G4200DFilter.h"
+#include "L3G4200DCapture.h"
+#include "SensorBus.h"
+#include "SensorArray.h"
+#include "SensorScanner.h"
 #include "L3G4200D.h"
 #include "HMC5883L.h"
 #include "ADXL345.h"
+#include "ADXL345Events.h"
 #include "BMP085.h"
+#include "BMP085Oversampler.h"
 
 
 #define COMPASS
 //#define GYRO
+//#define GYRO_SPI      // requires GYRO, CS on pin 10
+//#define GYRO_PAIR     // requires GYRO, second L3G4200D with SDO low
+//#define GYRO_FILTER   // requires GYRO, on-chip high-pass (bias drift) and LPF2 (noise)
+//#define GYRO_DRIFT    // requires GYRO, learn and remove the zero rate drift with temperature
+//#define GYRO_CAPTURE  // requires GYRO, INT1 wired to pin 3, prints 32 samples around a spin instead of each reading
+//#define GYRO_SMOOTH   // requires GYRO, fixed-point low-pass of the gyro counts at the loop rate
 //#define ACCEL
+//#define ACCEL_EVENTS  // requires ACCEL, INT1 wired to pin 2
+//#define ACCEL_DECIMATE  // requires ACCEL, INT1 wired to pin 2, 800Hz through the FIFO cut to 100Hz, not with ACCEL_EVENTS
 #define PRESSURE
+//#define PRESSURE_OVERSAMPLE  // requires PRESSURE, 5ms conversions averaged in software
+//#define BUS_BENCHMARK
+//#define DRIVER_BENCHMARK  // CSV timings of the driver hot paths on a simulated bus
+//#define BUS_TIMING
+//#define AUTODETECT    // find the sensors at run time, GYRO, COMPASS, ACCEL and PRESSURE are then not set up
+//#define FAST_BOOT     // skip the diagnostics and reuse the stored BMP085 calibration
+// BOOT_PROFILE in BootProfiler.h reports the time spent in each setup phase
+//#define TRACE         // sample latency and loop jitter histograms, send 't' to dump them
+//#define NEW_DATA_ONLY // only print samples the sensors flag as new, not with ACCEL_EVENTS
+//#define ALIGN         // print frames of all the sensors resampled onto one timebase
+//#define HEADING       // requires GYRO and COMPASS, heading at the gyro rate corrected by the compass
+//#define VERTICAL      // requires ACCEL and PRESSURE, altitude and climb rate from both, board level
+
+#ifdef ACCEL_DECIMATE
+#define I2C_CLOCK SENSOR_I2C_CLOCK_FAST  // the 800Hz FIFO drain needs fast mode
+#else
+#define I2C_CLOCK SENSOR_I2C_CLOCK   // SENSOR_I2C_CLOCK_FAST for 400kHz
+#endif
+#define LOOP_RATE 10                 // loop() runs about every 100ms
+#define GYRO_DATARATE L3G4200D::DATARATE_100HZ_12_5  // up to DATARATE_800HZ_110
+#define GYRO_HPF_CUTOFF 6            // HPCF code, 0.1Hz at 100Hz
+#define GYRO_CAPTURE_THRESHOLD 2000  // raw counts, about 17dps at 250dps full scale
+#define ALIGN_RATE 10                // frames per second
+#define ALIGN_DELAY 200000L          // frames trail by this many us, longer than the slowest read
+#define STATS_PERIOD 100             // loops between bus statistics reports, needs SENSOR_BUS_STATS
+
+#ifdef AUTODETECT
+SensorScanner scanner;
+#endif
+
+// Overlaps the sensor settling times, and profiles setup() with BOOT_PROFILE
+BootProfiler boot;
+
+#ifdef TRACE
+SensorTrace loopTrace = SensorTrace(1000000L / LOOP_RATE);
+SensorTrace compassTrace = SensorTrace(1000000L / LOOP_RATE);
+SensorTrace pressureTrace = SensorTrace(1000000L / LOOP_RATE);
+#endif
+
+#ifdef HEADING
+HeadingEstimator headingEstimator;
+#endif
+
+#ifdef VERTICAL
+VerticalKalman vertical;
+#endif
+
+#ifdef ALIGN
+SensorAlign aligner = SensorAlign(1000000L / ALIGN_RATE, ALIGN_DELAY);
+#endif
+
+// Sensors that failed to start are skipped rather than halting the board
+bool gyroPresent = false;
+bool compassPresent = false;
+bool pressurePresent = false;
 
 #ifdef ACCEL
 ADXL345 accel;
 #endif
 
+#ifdef ACCEL_DECIMATE
+// Third order CIC with droop compensation, 800Hz / 8 = 100Hz
+#define ACCEL_INT_PIN 2
+#define ACCEL_WATERMARK 16  // 20ms of samples at 800Hz, the FIFO is full at 40ms
+CicDecimator accelDecimator = CicDecimator(8, 3, true);
+int16_t accelDecimated[3];
+uint16_t accelOutputs = 0;
+uint16_t accelOverruns = 0;   // overruns and failed reads, each restarts the decimator
+#endif
+
+#ifdef ACCEL_EVENTS
+#define ACCEL_INT_PIN 2
+ADXL345Events accelEvents = ADXL345Events(&accel);
+#endif
+
 #ifdef COMPASS
 HMC5883L compass = HMC5883L();
 #endif
@@ -40,15 +135,51 @@ HMC5883L compass = HMC5883L();
 L3G4200D gyro;
 #endif
 
+#ifdef GYRO_DRIFT
+L3G4200DDrift gyroDrift;
+#endif
+
+#ifdef GYRO_SMOOTH
+BiquadBank gyroSmoothing = BiquadBank(3);
+#endif
+
+#ifdef GYRO_CAPTURE
+#define GYRO_INT_PIN 3
+L3G4200DCapture gyroCapture = L3G4200DCapture(&gyro);
+#endif
+
+#ifdef GYRO_PAIR
+L3G4200D gyro2 = L3G4200D(2, L3G4200D_ADDRESS_ALT);
+Sensor *gyros[] = { &gyro, &gyro2 };
+SensorArray gyroArray = SensorArray(gyros, 2);
+#endif
+
+#ifdef GYRO_SPI
+#define GYRO_CS_PIN 10
+SPIBus gyroSpi = SPIBus(GYRO_CS_PIN, 10000000L);
+#endif
+
 #ifdef PRESSURE
 BMP085 bmp = BMP085(10085);
 #endif
 
+#ifdef PRESSURE_OVERSAMPLE
+// 16 conversion average with an output every 16, about one per loop.
+// waitPolling() keeps the conversions back to back through the loop
+// delay, readBMP085() reports the latest output.
+BMP085Oversampler barometerOversampler = BMP085Oversampler(&bmp);
+bool pressureFresh = false;
+#endif
+
 /********************************************************/
 /* Helper routine to output sensor details
 /********************************************************/
 void displaySensorDetails(sensor_t sensor)
 {
+	#ifdef FAST_BOOT
+	return;
+	#endif
+	
 	Serial.println("------------------------------------");
 	Serial.print ("Sensor: "); Serial.println(sensor.name);
 	Serial.print ("Driver Ver: "); Serial.println(sensor.version);
@@ -66,19 +197,81 @@ void displaySensorDetails(sensor_t sensor)
  **/
 #ifdef PRESSURE
 
-void setupBMP085() {
+#ifdef FAST_BOOT
+#define CALIBRATION_EEPROM_ADDRESS 0
+#define CALIBRATION_MAGIC 0xB5
+
+/**
+* Load the BMP085 calibration saved by a previous boot, the stored copy
+* is guarded by a marker byte and a simple checksum. Whether it belongs
+* to the part fitted now is checked by BMP085::begin().
+**/
+bool loadBMP085Calibration(bmp085_calib_data *coeffs) {
+	uint8_t *bytes = (uint8_t*)coeffs;
+	uint8_t sum = 0;
+	
+	if( EEPROM.read(CALIBRATION_EEPROM_ADDRESS) != CALIBRATION_MAGIC ) {
+		return false;
+	}
+	for(uint8_t i = 0; i < sizeof(bmp085_calib_data); i++) {
+		bytes[i] = EEPROM.read(CALIBRATION_EEPROM_ADDRESS + 1 + i);
+		sum += bytes[i];
+	}
+	return EEPROM.read(CALIBRATION_EEPROM_ADDRESS + 1 + sizeof(bmp085_calib_data)) == sum;
+}
+
+/**
+* Save the BMP085 calibration for the next boot
+**/
+void saveBMP085Calibration(const bmp085_calib_data *coeffs) {
+	const uint8_t *bytes = (const uint8_t*)coeffs;
+	uint8_t sum = 0;
+	
+	EEPROM.write(CALIBRATION_EEPROM_ADDRESS, CALIBRATION_MAGIC);
+	for(uint8_t i = 0; i < sizeof(bmp085_calib_data); i++) {
+		EEPROM.write(CALIBRATION_EEPROM_ADDRESS + 1 + i, bytes[i]);
+		sum += bytes[i];
+	}
+	EEPROM.write(CALIBRATION_EEPROM_ADDRESS + 1 + sizeof(bmp085_calib_data), sum);
+}
+#endif
+
+boolean setupBMP085() {
+	#ifdef FAST_BOOT
+	bmp085_calib_data coeffs;
+	if( loadBMP085Calibration(&coeffs) ) {
+		// begin() reads every coefficient again when AC1 on the device
+		// doesn't match, in which case the stored copy is replaced
+		int16_t storedAc1 = coeffs.ac1;
+		if( !bmp.begin(BMP085_MODE_ULTRAHIGHRES, &coeffs) ) {
+			return false;
+		}
+		bmp.getCoefficients(&coeffs);
+		if( coeffs.ac1 != storedAc1 ) {
+			saveBMP085Calibration(&coeffs);
+		}
+		return true;
+	}
+	#endif
+	
 	Serial.println("Initialising BMP085");
 	if(!bmp.begin())
 	{
 		/* There was a problem detecting the BMP085 ... check your connections */
-		Serial.print("Ooops, no BMP085 detected ... Check your wiring or I2C ADDR!");
-		while(1);
+		Serial.println("Ooops, no BMP085 detected ... Check your wiring or I2C ADDR!");
+		return false;
 	}
 	
+	#ifdef FAST_BOOT
+	bmp.getCoefficients(&coeffs);
+	saveBMP085Calibration(&coeffs);
+	#endif
+	
 	sensor_t sensor;
 	bmp.getSensor(&sensor);
 	
 	displaySensorDetails(sensor);
+	return true;
 }
 
 /*****************************************************************/
@@ -88,7 +281,34 @@ void readBMP085() {
 	
 	/* Get a new sensor event */
 	sensors_event_t event;
-	bmp.getEvent(&event);
+	#ifdef PRESSURE_OVERSAMPLE
+	// Never waits, the next conversion is already running
+	if( barometerOversampler.poll() ) {
+		pressureFresh = true;
+	}
+	if( !pressureFresh ) {
+		if( barometerOversampler.getStatus() != SENSOR_BUS_OK ) {
+			Serial.println("BMP085 read failed");
+		}
+		return;
+	}
+	pressureFresh = false;
+	memset(&event, 0, sizeof(event));
+	event.type = SENSOR_TYPE_PRESSURE;
+	event.pressure = barometerOversampler.getPressure();
+	event.timestamp = millis();
+	#else
+	if( bmp.getEvent(&event) != SENSOR_BUS_OK ) {
+		Serial.println("BMP085 read failed");
+		return;
+	}
+	#endif
+	#ifdef TRACE
+	pressureTrace.record(&event);
+	#endif
+	#ifdef ALIGN
+	aligner.push(SENSOR_ALIGN_PRESSURE, &event);
+	#endif
 	
 	/* Display the results (barometric pressure is measure in hPa) */
 	if (event.pressure)
@@ -96,7 +316,11 @@ void readBMP085() {
 		/* Display atmospheric pressue in hPa */
 		Serial.print("Pressure: ");
 		Serial.print(event.pressure);
-		Serial.println(" hPa");
+		Serial.print(" hPa at ");
+		Serial.print(event.timestamp);
+		Serial.print(" ms, ");
+		Serial.print(event.latency);
+		Serial.println(" us old");
 		
 		/* Calculating altitude with reasonable accuracy requires pressure *
 		* sea level pressure for your position at the moment the data is *
@@ -115,7 +339,12 @@ void readBMP085() {
 		
 		/* First we get the current temperature from the BMP085 */
 		float temperature;
+		#ifdef PRESSURE_OVERSAMPLE
+		// A blocking conversion here would cut into the pipeline
+		temperature = barometerOversampler.getTemperature();
+		#else
 		bmp.getTemperature(&temperature);
+		#endif
 		Serial.print("Temperature: ");
 		Serial.print(temperature);
 		Serial.println(" C");
@@ -123,11 +352,25 @@ void readBMP085() {
 		/* Then convert the atmospheric pressure, SLP and temp to altitude */
 		/* Update this next line with the current SLP for better results */
 		float seaLevelPressure = SENSORS_PRESSURE_SEALEVELHPA;
-		Serial.print("Altitude: ");
-		Serial.print(bmp.pressureToAltitude(seaLevelPressure,
+		float altitude = bmp.pressureToAltitude(seaLevelPressure,
 		event.pressure,
-		temperature));
+		temperature);
+		Serial.print("Altitude: ");
+		Serial.print(altitude);
 		Serial.println(" m");
+		
+		#ifdef VERTICAL
+		vertical.correct((int32_t)(altitude * 1000));
+		if( vertical.isValid() ) {
+			sensors_event_t estimate;
+			vertical.getEvent(&estimate);
+			Serial.print("Filtered altitude: ");
+			Serial.print(estimate.acceleration.x);
+			Serial.print(" m, climbing ");
+			Serial.print(estimate.acceleration.y);
+			Serial.println(" m/s");
+		}
+		#endif
 		Serial.println("");
 	}
 	else
@@ -146,7 +389,156 @@ void readBMP085() {
 */
 void setupADXL345() {
 	accel.powerOn();
+	
+	#ifdef VERTICAL
+	// One accelerometer and one barometer reading per loop. The filter is
+	// meant to predict at the accelerometer rate; this sketch only reads
+	// one sample per 100ms loop, so it predicts at LOOP_RATE instead and
+	// the accelerometer is effectively sampled at 10Hz.
+	vertical.configure(1000000L / LOOP_RATE, 1, 0.35F, 0.5F, 0.01F);
+	#endif
+	
+	#ifdef NEW_DATA_ONLY
+	accel.setNewDataOnly(true);
+	#endif
+	
+	#ifdef ACCEL_DECIMATE
+	// 800Hz is 20% of the 400kHz bus. The FIFO raises WATERMARK on INT1
+	// at 16 entries and waitDraining() empties it in place of the loop
+	// delay. 3200Hz (ADXL345_BW_1600) takes most of a 400kHz bus, put the
+	// ADXL345 on an SPIBus for that and a ratio of 32 still gives 100Hz.
+	accel.set_bw(ADXL345_BW_400);
+	accel.setFifoMode(ADXL345_FIFO_STREAM, ACCEL_WATERMARK);
+	accel.setInterruptMapping(ADXL345_INT_WATERMARK_BIT, ADXL345_INT1_PIN);
+	accel.setInterrupt(ADXL345_INT_WATERMARK_BIT, true);
+	pinMode(ACCEL_INT_PIN, INPUT);
+	#endif
+	
+	#ifdef ACCEL_EVENTS
+	// Thresholds are all 62.5mg/LSB, times as per the datasheet scale factors
+	accel.setTapDetectionOnX(true);
+	accel.setTapDetectionOnY(true);
+	accel.setTapDetectionOnZ(true);
+	accel.setTapThreshold(50);
+	accel.setTapDuration(15);
+	accel.setDoubleTapLatency(80);
+	accel.setDoubleTapWindow(200);
+	accel.setFreeFallThreshold(7);
+	accel.setFreeFallDuration(45);
+	
+	if( !accelEvents.begin(ACCEL_INT_PIN) ) {
+		Serial.println("ADXL345 events setup FAILED");
+	}
+	
+	// 100Hz while moving, 12.5Hz in low power after 10s still
+	accelEvents.enableAdaptiveRate(ADXL345_BW_50, ADXL345_BW_6, 75, 75, 10);
+	#endif
+}
+
+#ifdef ACCEL_EVENTS
+/**
+* Print any motion events raised by the accelerometer
+*/
+void readADXL345Events() {
+	adxl345_event_t event;
+	
+	accelEvents.poll();
+	while( accelEvents.pop(&event) ) {
+		Serial.print("Motion event ");
+		Serial.print(event.type);
+		Serial.print(" axes ");
+		Serial.print(event.axes, BIN);
+		Serial.print(" at ");
+		Serial.println(event.timestamp);
+		
+		if( event.type == ADXL345_EVENT_RATE_CHANGE ) {
+			Serial.print("Accel rate ");
+			Serial.print(ADXL345Events::rateFromCode(event.rateCode));
+			Serial.println("Hz");
+		}
+	}
+}
+#endif
+
+#ifdef ACCEL_DECIMATE
+/**
+* Empty the FIFO into the decimator. An overrun means samples were lost,
+* so the decimator is restarted rather than fed a spliced stream.
+*/
+void drainADXL345Fifo() {
+	static int16_t fifo[ADXL345_FIFO_SIZE][3];
+	
+	// OVERRUN stays set until the FIFO is read, so check it first
+	if( accel.getInterruptSource(ADXL345_INT_OVERRUNY_BIT) ) {
+		accelOverruns++;
+		accelDecimator.reset();
+	}
+	
+	uint8_t count = accel.getFifoEntries();
+	if( count > ADXL345_FIFO_SIZE ) {
+		count = ADXL345_FIFO_SIZE;
+	}
+	if( accel.readFifo(fifo, count) != SENSOR_BUS_OK ) {
+		accelOverruns++;
+		accelDecimator.reset();
+		return;
+	}
+	for(uint8_t i = 0; i < count; i++) {
+		if( accelDecimator.push(fifo[i], accelDecimated) ) {
+			accelOutputs++;
+		}
+	}
+}
+
+/**
+* Drain what is left, then print the last output and how many outputs
+* and restarts there have been since the last call
+*/
+void readADXL345Decimated() {
+	drainADXL345Fifo();
+	
+	Serial.print("Decimated XYZ COUNTS: ");
+	Serial.print(accelDecimated[0]);
+	Serial.print(" ");
+	Serial.print(accelDecimated[1]);
+	Serial.print(" ");
+	Serial.print(accelDecimated[2]);
+	Serial.print(" (");
+	Serial.print(accelOutputs);
+	Serial.print(" samples, ");
+	Serial.print(accelOverruns);
+	Serial.println(" restarts)");
+	accelOutputs = 0;
+	accelOverruns = 0;
+}
+#endif
+
+#if defined(ACCEL_DECIMATE) || defined(PRESSURE_OVERSAMPLE)
+/**
+* Stands in for the loop delay, keeping up with the sensors that need
+* more than one look per loop: the accelerometer FIFO is drained each
+* time INT1 shows it has reached the watermark and the barometer starts
+* its next conversion as soon as one finishes. The rest of loop() must
+* stay under the 20ms between the watermark and a full FIFO, so a slow
+* Serial rate and the other sensors will show up as restarts.
+*/
+void waitPolling(uint32_t ms) {
+	uint32_t start = millis();
+	
+	while( millis() - start < ms ) {
+		#ifdef ACCEL_DECIMATE
+		if( digitalRead(ACCEL_INT_PIN) == HIGH ) {
+			drainADXL345Fifo();
+		}
+		#endif
+		#ifdef PRESSURE_OVERSAMPLE
+		if( pressurePresent && barometerOversampler.poll() ) {
+			pressureFresh = true;
+		}
+		#endif
+	}
 }
+#endif
 
 /**
 * Read some of the values from the accelerometer
@@ -155,7 +547,9 @@ void readADXL345() {
 	int x, y, z, i;
 	double xyz[3], gains[3], gains_orig[3];
 	
-	accel.readAccel(&x, &y, &z);
+	if( accel.readAccel(&x, &y, &z) == SENSOR_BUS_NO_DATA ) {
+		return;
+	}
 	Serial.print("XYZ COUNTS: ");
 	Serial.print(x, DEC);
 	Serial.print(" ");
@@ -165,6 +559,14 @@ void readADXL345() {
 	Serial.println("");
 
 	accel.get_Gxyz(xyz);
+	#ifdef VERTICAL
+	// Z is vertical with the board level
+	vertical.predict((int16_t)(xyz[2] * 1000));
+	#endif
+	#ifdef ALIGN
+	float g[3] = { (float)xyz[0], (float)xyz[1], (float)xyz[2] };
+	aligner.push(SENSOR_ALIGN_ACCEL, g, micros());
+	#endif
 	Serial.print("XYZ Gs: ");
 	for(i = 0; i<3; i++){
 		Serial.print(xyz[i], DEC);
@@ -176,28 +578,189 @@ void readADXL345() {
 #endif
 
 
+#ifdef GYRO_FILTER
+/**
+* Show what the chosen gyro filters do to a step change in rate, using
+* the filter model: how long the high-pass takes to remove half a bias
+* step and the peak that gets through the low-pass
+**/
+void reportGyroFilter() {
+	L3G4200DFilter model;
+	float peak = 0;
+	uint16_t halfLife = 0;
+	
+	model.configure(GYRO_DATARATE, L3G4200D::OUTPUT_LPF2, true, GYRO_HPF_CUTOFF);
+	for(uint16_t i = 1; i <= 60000 && halfLife == 0; i++) {
+		float out = model.update(1.0F);
+		if( out > peak ) {
+			peak = out;
+		} else if( out < 0.5F * peak ) {
+			halfLife = i;
+		}
+	}
+	
+	Serial.print("Gyro HPF ");
+	Serial.print(L3G4200D::highPassHz(GYRO_DATARATE, GYRO_HPF_CUTOFF));
+	Serial.print("Hz LPF2 ");
+	Serial.print(L3G4200D::bandwidthHz(GYRO_DATARATE));
+	Serial.print("Hz: step peak ");
+	Serial.print(peak);
+	Serial.print(", bias halved after ");
+	Serial.print(halfLife);
+	Serial.println(" samples");
+}
+#endif
+
 #ifdef GYRO
 /**
 * Setup the L3G4200D digital gyroscope
 **/
 boolean setupL3G4200D() {
-	return gyro.setup( gyro.RANGE_250DPS);
+	#ifdef GYRO_SPI
+	gyro.setBus(&gyroSpi);
+	#endif
+	#ifdef NEW_DATA_ONLY
+	gyro.setNewDataOnly(true);
+	#endif
+	#ifdef GYRO_PAIR
+	#ifdef NEW_DATA_ONLY
+	gyro2.setNewDataOnly(true);
+	#endif
+	if( !gyro2.setup( gyro2.RANGE_250DPS, GYRO_DATARATE) ) {
+		return false;
+	}
+	#endif
+	if( !gyro.setup( gyro.RANGE_250DPS, GYRO_DATARATE) ) {
+		return false;
+	}
+	
+	#ifdef GYRO_DRIFT
+	gyro.setDriftCompensation(&gyroDrift);
+	#endif
+	
+	#ifdef GYRO_FILTER
+	gyro.setHighPass(L3G4200D::HPF_NORMAL, GYRO_HPF_CUTOFF);
+	gyro.setOutput(L3G4200D::OUTPUT_LPF2, true);
+	reportGyroFilter();
+	#endif
+	
+	#ifdef GYRO_SMOOTH
+	// 1Hz Butterworth at the 10Hz loop rate
+	biquad_t section;
+	BiquadBank::lowPass(&section, LOOP_RATE, 1.0F);
+	gyroSmoothing.addSection(&section);
+	#endif
+	
+	#ifdef HEADING
+	// Z up on both sensors, declination as in readHMC5883L
+	headingEstimator.setGyroScale(-L3G4200D_SENSITIVITY_250DPS);
+	headingEstimator.setDeclination(0.0457);
+	#endif
+	
+	#ifdef GYRO_CAPTURE
+	// Eight samples after the trigger leaves 24 before it, 240ms at 100Hz so
+	// the 100ms loop polls in time. At 800Hz they last 30ms and are lost.
+	byte events = L3G4200D_INT1_XHIE | L3G4200D_INT1_YHIE | L3G4200D_INT1_ZHIE;
+	if( !gyroCapture.begin(GYRO_INT_PIN, events, GYRO_CAPTURE_THRESHOLD, 0, 8) ) {
+		Serial.println("L3G4200D capture setup FAILED");
+	}
+	#endif
+	return true;
 }
 
+#ifdef GYRO_CAPTURE
+/**
+* Print a captured block as CSV, one sample per line
+**/
+void readL3G4200DCapture() {
+	static l3g4200d_capture_t capture;
+	
+	if( !gyroCapture.poll(&capture) ) {
+		return;
+	}
+	
+	Serial.print("Gyro capture at ");
+	Serial.print(capture.timestamp);
+	Serial.print(" source ");
+	Serial.println(capture.source, BIN);
+	Serial.println("n,x,y,z");
+	for(uint8_t i = 0; i < capture.count; i++) {
+		Serial.print((int)i - capture.trigger); Serial.print(",");
+		Serial.print(capture.xyz[i][0]); Serial.print(",");
+		Serial.print(capture.xyz[i][1]); Serial.print(",");
+		Serial.println(capture.xyz[i][2]);
+	}
+}
+#endif
+
 /**
 * Rad the gyro and output the result
 *
 **/
 void readL3G4200D() {
-	gyro.read();
+	#ifdef GYRO_PAIR
+	// One gyro per pass, alternating between the pair
+	sensors_event_t event;
+	uint8_t status;
+	uint8_t index = gyroArray.next(&event, &status);
+	L3G4200D *current = (L3G4200D*)gyroArray.get(index);
+	if( status == SENSOR_BUS_NO_DATA ) {
+		return;
+	}
+	
+	Serial.print("G");
+	Serial.print(index);
+	Serial.print(" ");
+	#else
+	L3G4200D *current = &gyro;
+	if( current->read() == SENSOR_BUS_NO_DATA ) {
+		return;
+	}
 
 	Serial.print("G ");
+	#endif
+	#ifdef ALIGN
+	#ifdef GYRO_PAIR
+	if( index == 0 )
+	#endif
+	aligner.push(SENSOR_ALIGN_GYRO, &current->g.x, micros());
+	#endif
 	Serial.print("X: ");
-	Serial.print((int)gyro.g.x);
+	Serial.print((int)current->g.x);
 	Serial.print(" Y: ");
-	Serial.print((int)gyro.g.y);
+	Serial.print((int)current->g.y);
 	Serial.print(" Z: ");
-	Serial.println((int)gyro.g.z);
+	Serial.print((int)current->g.z);
+	#ifdef NEW_DATA_ONLY
+	Serial.print(" overruns: ");
+	Serial.print(current->getOverruns());
+	#endif
+	#ifdef GYRO_SMOOTH
+	#ifdef GYRO_PAIR
+	if( index == 0 )
+	#endif
+	{
+		int16_t smooth[3];
+		gyroSmoothing.process(current->counts, smooth);
+		Serial.print(" smoothed: ");
+		Serial.print(smooth[0]);
+		Serial.print(" ");
+		Serial.print(smooth[1]);
+		Serial.print(" ");
+		Serial.print(smooth[2]);
+	}
+	#endif
+	#ifdef HEADING
+	#ifdef GYRO_PAIR
+	if( index == 0 )
+	#endif
+	headingEstimator.update(current->counts[2], micros());
+	if( headingEstimator.isValid() ) {
+		Serial.print(" heading: ");
+		Serial.print(((uint32_t)headingEstimator.heading() * 360) >> 16);
+	}
+	#endif
+	Serial.println();
 }
 #endif
 
@@ -215,8 +778,8 @@ boolean setupHMC5883L() {
 	if(!compass.begin() )
 	{
 		/* There was a problem detecting the BMP085 ... check your connections */
-		Serial.print("Ooops, no HMC883L detected ... Check your wiring or I2C ADDR!");
-		while(1);
+		Serial.println("Ooops, no HMC883L detected ... Check your wiring or I2C ADDR!");
+		return false;
 	}
 	
 	// Display the sensor
@@ -228,6 +791,10 @@ boolean setupHMC5883L() {
 	error = compass.SetScale(1.3f); // Set the scale of the compass.
 	error = compass.SetMeasurementMode(Measurement_Continuous); // Set the measurement mode to Continuous
 	
+	#ifdef NEW_DATA_ONLY
+	compass.setNewDataOnly(true);
+	#endif
+	
 	// If there is an error, print it out.
 	if(error != 0) {
 		Serial.println(compass.GetErrorText(error));
@@ -244,30 +811,35 @@ void readHMC5883L() {
 	
 	/* Get a new sensor event */
 	sensors_event_t event;
-	compass.getEvent(&event);
+	uint8_t result = compass.getEvent(&event);
+	if( result == SENSOR_BUS_NO_DATA ) {
+		return;
+	}
+	if( result != SENSOR_BUS_OK ) {
+		Serial.println("HMC5883L read failed");
+		return;
+	}
+	#ifdef TRACE
+	compassTrace.record(&event);
+	#endif
+	#ifdef ALIGN
+	aligner.push(SENSOR_ALIGN_MAGNETIC, &event);
+	#endif
+	#ifdef HEADING
+	headingEstimator.correct((int16_t)event.magnetic.x, (int16_t)event.magnetic.y);
+	#endif
 	
 	/* Display the results (barometric pressure is measure in hPa) */
 	if (event.type == SENSOR_TYPE_MAGNETIC_FIELD)
 	{
-		// Calculate heading when the magnetometer is level, then correct for signs of axis.
-		float heading = atan2(event.orientation.y, event.orientation.x);
-		
 		// Once you have your heading, you must then add your 'Declination Angle', which is the 'Error' of the magnetic field in your location.
 		// Find yours here: http://www.magnetic-declination.com/
 		// Mine is: 2? 37' W, which is 2.617 Degrees, or (which we need) 0.0456752665 radians, I will use 0.0457
-		// If you cannot find your Declination, comment out these two lines, your compass will be slightly off.
+		// If you cannot find your Declination, set this to 0, your compass will be slightly off.
 		float declinationAngle = 0.0457;
-		heading += declinationAngle;
 		
-		// Correct for when signs are reversed.
-		if(heading < 0) {
-			heading += 2*PI;
-		}
-		
-		// Check for wrap due to addition of declination.
-		if(heading > 2*PI) {
-			heading -= 2*PI;
-		}
+		// Calculate heading when the magnetometer is level, corrected for signs of axis.
+		float heading = HMC5883L::heading(event.orientation.x, event.orientation.y, declinationAngle);
 		
 		// Convert radians to degrees for readability.
 		float headingDegrees = heading * 180/M_PI;
@@ -276,40 +848,322 @@ void readHMC5883L() {
 		Serial.print(heading);
 		Serial.print(" Radians   \t");
 		Serial.print(headingDegrees);
-		Serial.println(" Degrees   \t");
+		Serial.print(" Degrees   \tat ");
+		Serial.print(event.timestamp);
+		Serial.println(" ms");
+	}
+}
+
+#endif
+
+#ifdef BUS_BENCHMARK
+#define BENCHMARK_SAMPLES 100
+
+/**
+* Read gyro and accelerometer samples through a simulated bus and report
+* the modelled transfer time per sample alongside the time spent on the MCU
+**/
+void benchmarkTransport(const char *name, SimulatedBus *bus) {
+	L3G4200D simGyro;
+	ADXL345 simAccel;
+	int xyz[3];
+	unsigned long start;
+	
+	simGyro.setBus(bus);
+	simAccel.setBus(bus);
+	
+	Serial.print(name);
+	Serial.print(" @ ");
+	Serial.print(bus->getClock());
+	Serial.println("Hz");
+	
+	bus->resetTiming();
+	start = micros();
+	for(int i = 0; i < BENCHMARK_SAMPLES; i++) {
+		simGyro.read();
+	}
+	Serial.print("  L3G4200D us/sample bus: ");
+	Serial.print(bus->elapsedMicros() / BENCHMARK_SAMPLES);
+	Serial.print(" mcu: ");
+	Serial.println((micros() - start) / BENCHMARK_SAMPLES);
+	
+	bus->resetTiming();
+	start = micros();
+	for(int i = 0; i < BENCHMARK_SAMPLES; i++) {
+		simAccel.readAccel(xyz);
+	}
+	Serial.print("  ADXL345 us/sample bus: ");
+	Serial.print(bus->elapsedMicros() / BENCHMARK_SAMPLES);
+	Serial.print(" mcu: ");
+	Serial.println((micros() - start) / BENCHMARK_SAMPLES);
+}
+
+/**
+* Compare the I2C and SPI transports, one simulated bus at a time to save RAM
+**/
+void benchmarkBus() {
+	{
+		SimulatedBus bus(SimulatedBus::TRANSPORT_I2C, 100000L, 0x7F);
+		benchmarkTransport("I2C", &bus);
+	}
+	{
+		SimulatedBus bus(SimulatedBus::TRANSPORT_SPI, 5000000L);
+		benchmarkTransport("SPI", &bus);
+	}
+}
+#endif
+
+#ifdef BUS_TIMING
+/**
+* Report how much of the I2C bus the enabled sensors use at each clock
+**/
+void reportBusTiming() {
+	i2c_schedule_t schedule[4];
+	uint8_t count = 0;
+	
+	#ifdef GYRO
+	schedule[count].bytes = 6; schedule[count].reads = 1;
+	schedule[count].rate = LOOP_RATE; schedule[count++].maxClock = L3G4200D_MAX_I2C_CLOCK;
+	#endif
+	#ifdef COMPASS
+	schedule[count].bytes = 6; schedule[count].reads = 1;
+	schedule[count].rate = LOOP_RATE; schedule[count++].maxClock = HMC5883L_MAX_I2C_CLOCK;
+	#endif
+	#ifdef ACCEL
+	schedule[count].bytes = 6; schedule[count].reads = 1;
+	schedule[count].rate = LOOP_RATE; schedule[count++].maxClock = ADXL345_MAX_I2C_CLOCK;
+	#endif
+	#ifdef PRESSURE
+	// getEvent reads UT and UP, readBMP085 then reads UT again
+	schedule[count].bytes = 3; schedule[count].reads = 3;
+	schedule[count].rate = LOOP_RATE; schedule[count++].maxClock = BMP085_MAX_I2C_CLOCK;
+	#endif
+	
+	Serial.print("I2C utilization at 100kHz: ");
+	Serial.print(I2CBus::utilization(schedule, count, SENSOR_I2C_CLOCK));
+	Serial.println("%");
+	Serial.print("I2C utilization at 400kHz: ");
+	Serial.print(I2CBus::utilization(schedule, count, SENSOR_I2C_CLOCK_FAST));
+	Serial.println("%");
+	Serial.print("Worst case blocking per read: ");
+	Serial.print(I2CBus::worstCaseMicros());
+	Serial.println(" us");
+}
+#endif
+
+#ifdef AUTODETECT
+/**
+* Find and start whatever sensors are on the bus
+**/
+void setupScanner() {
+	sensor_t sensor;
+	uint8_t found = scanner.scan();
+	
+	Serial.print("Found ");
+	Serial.print(found);
+	Serial.println(" sensors");
+	
+	for(uint8_t i = 0; i < found; i++) {
+		scanner.get(i)->getSensor(&sensor);
+		displaySensorDetails(sensor);
+	}
+}
+
+/**
+* Read every sensor that was found and print the raw event data
+**/
+void readScanned() {
+	sensors_event_t event;
+	
+	for(uint8_t i = 0; i < scanner.size(); i++) {
+		uint8_t result = scanner.get(i)->getEvent(&event);
+		Serial.print(event.sensor_id, HEX);
+		if( result != SENSOR_BUS_OK ) {
+			Serial.print(" read failed: ");
+			Serial.println(result);
+			continue;
+		}
+		Serial.print(" type ");
+		Serial.print(event.type);
+		Serial.print(": ");
+		Serial.print(event.data[0]);
+		Serial.print(" ");
+		Serial.print(event.data[1]);
+		Serial.print(" ");
+		Serial.println(event.data[2]);
+	}
+}
+#endif
+
+#ifdef SENSOR_BUS_STATS
+/**
+* Print the bus statistics collected for one device then start afresh
+**/
+void reportStats(const char *name, Sensor *sensor) {
+	const sensor_bus_stats_t *stats = sensor->getStats();
+	
+	Serial.print(name);
+	Serial.print(": "); Serial.print(stats->transactions);
+	Serial.print(" transfers, "); Serial.print(stats->bytes);
+	Serial.print(" bytes, "); Serial.print(stats->errors);
+	Serial.print(" errors, "); Serial.print(stats->retries);
+	Serial.print(" retries, "); Serial.print(stats->micros);
+	Serial.print(" us (min "); Serial.print(stats->minMicros);
+	Serial.print(" max "); Serial.print(stats->maxMicros);
+	Serial.print(") histogram");
+	for(uint8_t i = 0; i < SENSOR_BUS_HISTOGRAM_BINS; i++) {
+		Serial.print(" ");
+		Serial.print(stats->histogram[i]);
+	}
+	Serial.println();
+	sensor->resetStats();
+}
+
+/**
+* Report every enabled device
+**/
+void reportBusStats() {
+	#ifdef AUTODETECT
+	for(uint8_t i = 0; i < scanner.size(); i++) {
+		reportStats("Scanned", scanner.get(i));
+	}
+	#else
+	#ifdef GYRO
+	reportStats("L3G4200D", &gyro);
+	#endif
+	#ifdef COMPASS
+	reportStats("HMC5883L", &compass);
+	#endif
+	#ifdef ACCEL
+	reportStats("ADXL345", &accel);
+	#endif
+	#ifdef PRESSURE
+	reportStats("BMP085", &bmp);
+	#endif
+	#endif /* AUTODETECT */
+}
+#endif
+
+#ifdef TRACE
+/**
+* Dump the latency and jitter histograms when 't' arrives on the serial port
+**/
+void checkTraceRequest() {
+	if( Serial.available() && Serial.read() == 't' ) {
+		Serial.println("loop()");
+		loopTrace.dump(&Serial);
+		#ifdef COMPASS
+		Serial.println("HMC5883L");
+		compassTrace.dump(&Serial);
+		#endif
+		#ifdef PRESSURE
+		Serial.println("BMP085");
+		pressureTrace.dump(&Serial);
+		#endif
 	}
 }
+#endif
 
+#ifdef ALIGN
+/**
+* Print the aligned frames that have fallen due as CSV: time, gyro xyz,
+* accel xyz, magnetic xyz, pressure and the interpolated channel mask
+**/
+void printAlignedFrames() {
+	sensor_frame_t frame;
+	
+	while( aligner.next(&frame, micros()) ) {
+		Serial.print("F,");
+		Serial.print(frame.timestamp);
+		for(uint8_t i = 0; i < 3; i++) { Serial.print(","); Serial.print(frame.gyro[i]); }
+		for(uint8_t i = 0; i < 3; i++) { Serial.print(","); Serial.print(frame.accel[i]); }
+		for(uint8_t i = 0; i < 3; i++) { Serial.print(","); Serial.print(frame.magnetic[i]); }
+		Serial.print(",");
+		Serial.print(frame.pressure);
+		Serial.print(",");
+		Serial.println(frame.interpolated, BIN);
+	}
+}
 #endif
 
 /**
 * Setup the various sensors
 **/
 void setup() {
+	boot.begin();
 	Serial.begin(9600);
 	
+	// All sensors share the bus, so its clock is set once here
+	I2CBus::setBusClock(I2C_CLOCK);
+	
+	#ifdef BUS_TIMING
+	reportBusTiming();
+	#endif
+	
+	#ifdef BUS_BENCHMARK
+	benchmarkBus();
+	#endif
+	
+	#ifdef DRIVER_BENCHMARK
+	runDriverBenchmarks(&Serial);
+	#endif
+	
+	boot.mark("serial");
+	
+	#ifdef AUTODETECT
+	// The scanner owns every sensor it finds, a second driver on the
+	// same device would fight over its settings
+	setupScanner();
+	boot.mark("scan");
+	#else
+	
 	#ifdef GYRO
-	if( setupL3G4200D() ) {
+	gyroPresent = setupL3G4200D();
+	if( gyroPresent ) {
 		Serial.println("L3G4200D Gyro setup ok");
 		} else {
 		Serial.println("L3G4200D Gyro setup FAILED");
 	}
+	boot.settle(L3G4200D_STARTUP_MS);
+	boot.mark("gyro");
 	#endif
 	
 	#ifdef COMPASS
-	if( setupHMC5883L() ) {
+	compassPresent = setupHMC5883L();
+	if( compassPresent ) {
 		Serial.println("HMC5883L Compass setup ok");
 		} else {
 		Serial.println("HMC5883L Compass setup FAILED");
 	}
+	boot.settle(HMC5883L_STARTUP_MS);
+	boot.mark("compass");
 	#endif
 	
 	#ifdef ACCEL
 	setupADXL345();
+	boot.settle(ADXL345_STARTUP_MS);
+	boot.mark("accel");
 	#endif
 	
 	#ifdef PRESSURE
-	setupBMP085();
+	pressurePresent = setupBMP085();
+	boot.settle(BMP085_STARTUP_MS);
+	boot.mark("pressure");
+	#endif
+	#endif /* AUTODETECT */
+	
+	// Wait once for whichever sensor takes longest to produce data
+	boot.waitSettled();
+	boot.mark("settle");
+	
+	#ifdef PRESSURE_OVERSAMPLE
+	if( pressurePresent ) {
+		barometerOversampler.begin();
+	}
+	#endif
+	
+	#ifdef BOOT_PROFILE
+	boot.report(&Serial);
 	#endif
 }
 
@@ -323,25 +1177,68 @@ void setup() {
 **/
 void loop() {
 	
+	#ifdef TRACE
+	loopTrace.tick();
+	checkTraceRequest();
+	#endif
+	
+	#ifdef AUTODETECT
+	readScanned();
+	#else
+	
 	#ifdef GYRO
-	// Digital Gyro
+	// Digital Gyro, with GYRO_CAPTURE the FIFO owns the outputs and
+	// read() returns SENSOR_BUS_NO_DATA so nothing is printed here
+	if( gyroPresent )
 	readL3G4200D();
 	#endif
+	
+	#ifdef GYRO_CAPTURE
+	if( gyroPresent )
+	readL3G4200DCapture();
+	#endif
 
 	#ifdef COMPASS
 	// Digital Compass
+	if( compassPresent )
 	readHMC5883L();
 	#endif
 
 	#ifdef ACCEL
 	// Accelerometer
+	#ifdef ACCEL_DECIMATE
+	readADXL345Decimated();
+	#else
 	readADXL345();
 	#endif
+	#endif
+	
+	#ifdef ACCEL_EVENTS
+	readADXL345Events();
+	#endif
 	
 	#ifdef PRESSURE
+	if( pressurePresent )
 	readBMP085();
 	#endif
+	#endif /* AUTODETECT */
+	
+	#ifdef ALIGN
+	printAlignedFrames();
+	#endif
+	
+	#ifdef SENSOR_BUS_STATS
+	static uint16_t loops = 0;
+	if( ++loops >= STATS_PERIOD ) {
+		loops = 0;
+		reportBusStats();
+	}
+	#endif
 
 	// Wait for a short time
+	#if defined(ACCEL_DECIMATE) || defined(PRESSURE_OVERSAMPLE)
+	waitPolling(100);
+	#else
 	delay(100);
+	#endif
 }
@@ -16,24 +16,20 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 */
 #include "L3G4200D.h"
-#include <Wire.h>
 #include <math.h>
 
-// Defines ////////////////////////////////////////////////////////////////
-
-// The Arduino two-wire interface uses a 7-bit number for the address, 
-// and sets the last bit correctly based on reads and writes
-#define GYR_ADDRESS (0xD2 >> 1)
-
 // Public Methods //////////////////////////////////////////////////////////////
 
 // Turns on the L3G4200D's gyro and places it in normal mode.
-bool L3G4200D::setup(Range_t rng)
+// bdu holds the output registers until both halves of a reading have
+// been read, so a sample can't tear at the higher data rates.
+bool L3G4200D::setup(Range_t rng, Datarate_t rate, bool bdu)
 {
-	address = GYR_ADDRESS;
 	range = rng;
+	datarate = rate;
+	blockUpdate = bdu;
 	
-	Wire.begin();
+	bus->begin();
   
 	/* Make sure we have the correct chip ID since this checks
      for correct address and that the IC is properly connected */
@@ -56,8 +52,8 @@ bool L3G4200D::setup(Range_t rng)
      1  YEN       Y-axis enable (0 = disabled, 1 = enabled)           1
      0  XEN       X-axis enable (0 = disabled, 1 = enabled)           1 */
 
-	/* Switch to normal mode and enable all three channels */
-	writeReg(L3G4200D_CTRL_REG1, 0x0F);
+	/* Switch to normal mode at the chosen rate and enable all three channels */
+	writeControl1();
 	
 	/* ------------------------------------------------------------------ */
 
@@ -68,7 +64,7 @@ bool L3G4200D::setup(Range_t rng)
     5-4  HPM1/0    High-pass filter mode selection                    00
     3-0  HPCF3..0  High-pass filter cutoff frequency selection      0000 */
 
-	/* Nothing to do ... keep default values */
+	/* Nothing to do ... keep default values, see setHighPass() */
 	/* ------------------------------------------------------------------ */
 
 	/* Set CTRL_REG3 (0x22)
@@ -100,19 +96,8 @@ bool L3G4200D::setup(Range_t rng)
                                   11 = 2000 dps
     0  SIM       SPI Mode (0=4-wire, 1=3-wire)                       0 */
 
-	/* Adjust resolution if requested */
-	switch(range)
-	{	
-    case RANGE_250DPS:
-		writeReg(L3G4200D_CTRL_REG4, 0x00);
-		break;
-    case RANGE_500DPS:
-		writeReg(L3G4200D_CTRL_REG4, 0x10);
-		break;
-    case RANGE_2000DPS:
-		writeReg(L3G4200D_CTRL_REG4, 0x20);
-		break;
-  }
+	/* Adjust resolution and block data update if requested */
+	writeControl4();
   /* ------------------------------------------------------------------ */
 
   /* Set CTRL_REG5 (0x24)
@@ -125,37 +110,249 @@ bool L3G4200D::setup(Range_t rng)
    3-2  INT1_SEL  INT1 Selection config                              00
    1-0  OUT_SEL   Out selection config                               00 */
 
-  /* Nothing to do ... keep default values */
+  /* Nothing to do ... keep default values, see setOutput() */
   /* ------------------------------------------------------------------ */
 
 	return true;
 }
 
+// Attaches a drift model that learns and removes the temperature
+// dependent zero-rate level, NULL to detach
+void L3G4200D::setDriftCompensation(L3G4200DDrift *model)
+{
+	drift = model;
+}
+
+// Selects a FIFO mode (L3G4200D_FIFO_xxx), enabling the FIFO for any
+// mode other than bypass. Going through bypass empties the FIFO.
+void L3G4200D::setFifoMode(byte mode)
+{
+	byte ctrl5 = readReg(L3G4200D_CTRL_REG5) & ~L3G4200D_FIFO_EN;
+
+	fifoEnabled = mode != L3G4200D_FIFO_BYPASS;
+	if( fifoEnabled ) {
+		ctrl5 |= L3G4200D_FIFO_EN;
+	}
+	writeReg(L3G4200D_CTRL_REG5, ctrl5);
+	writeReg(L3G4200D_FIFO_CTRL_REG, mode);
+}
+
+// Number of samples waiting in the FIFO
+uint8_t L3G4200D::getFifoCount()
+{
+	byte src = readReg(L3G4200D_FIFO_SRC_REG);
+
+	if( src & L3G4200D_FIFO_OVRN ) {
+		return L3G4200D_FIFO_SIZE;
+	}
+	return src & L3G4200D_FIFO_FSS;
+}
+
+// Reads count samples from the FIFO, oldest first. With the FIFO on, an
+// auto-increment burst wraps from OUT_Z_H back to OUT_X_L and moves on
+// to the next entry, so several samples come in each transaction.
+uint8_t L3G4200D::readFifo(int16_t (*xyz)[3], uint8_t count)
+{
+	uint8_t buffer[L3G4200D_FIFO_BURST * 6];
+
+	for(uint8_t done = 0; done < count; ) {
+		uint8_t burst = count - done;
+		if( burst > L3G4200D_FIFO_BURST ) {
+			burst = L3G4200D_FIFO_BURST;
+		}
+
+		uint8_t result = bus->readRegisters(L3G4200D_OUT_X_L, buffer, burst * 6);
+		if( result != SENSOR_BUS_OK ) {
+			return result;
+		}
+
+		for(uint8_t i = 0; i < burst; i++, done++) {
+			for(uint8_t axis = 0; axis < 3; axis++) {
+				xyz[done][axis] = (int16_t)((buffer[i * 6 + axis * 2 + 1] << 8) | buffer[i * 6 + axis * 2]);
+			}
+		}
+	}
+	return SENSOR_BUS_OK;
+}
+
+// Raises INT1 when the selected axis events (L3G4200D_INT1_xHIE etc.)
+// pass threshold, in raw counts up to 0x7FFF, for duration samples. The
+// event latches until getInterruptSource() is called. events of 0 turns
+// the interrupt off.
+void L3G4200D::setThresholdInterrupt(byte events, uint16_t threshold, byte duration)
+{
+	byte ctrl3 = readReg(L3G4200D_CTRL_REG3) & ~L3G4200D_I1_INT1;
+	byte high = (threshold >> 8) & 0x7F;
+	byte low = threshold & 0xFF;
+
+	writeReg(L3G4200D_INT1_THS_XH, high);
+	writeReg(L3G4200D_INT1_THS_XL, low);
+	writeReg(L3G4200D_INT1_THS_YH, high);
+	writeReg(L3G4200D_INT1_THS_YL, low);
+	writeReg(L3G4200D_INT1_THS_ZH, high);
+	writeReg(L3G4200D_INT1_THS_ZL, low);
+	writeReg(L3G4200D_INT1_DURATION, duration ? (L3G4200D_INT1_WAIT | (duration & 0x7F)) : 0);
+
+	if( events ) {
+		writeReg(L3G4200D_INT1_CFG, events | L3G4200D_INT1_LIR);
+		ctrl3 |= L3G4200D_I1_INT1;
+	} else {
+		writeReg(L3G4200D_INT1_CFG, 0);
+	}
+	writeReg(L3G4200D_CTRL_REG3, ctrl3);
+}
+
+// Reads INT1_SRC, which also clears a latched interrupt
+byte L3G4200D::getInterruptSource()
+{
+	return readReg(L3G4200D_INT1_SRC);
+}
+
+// Changes the output data rate and bandwidth, takes effect immediately
+void L3G4200D::setDatarate(Datarate_t rate)
+{
+	datarate = rate;
+	writeControl1();
+}
+
+// Turns block data update on or off
+void L3G4200D::setBlockDataUpdate(bool enable)
+{
+	blockUpdate = enable;
+	writeControl4();
+}
+
+// Output data rate in Hz
+uint16_t L3G4200D::datarateHz(Datarate_t rate)
+{
+	return 100 << (rate >> 2);
+}
+
+// Low-pass cutoff in Hz, from the datasheet DR/BW table
+float L3G4200D::bandwidthHz(Datarate_t rate)
+{
+	static const float cutoff[16] = {
+		12.5F, 25.0F, 25.0F, 25.0F,
+		12.5F, 25.0F, 50.0F, 70.0F,
+		20.0F, 25.0F, 50.0F, 110.0F,
+		30.0F, 35.0F, 50.0F, 110.0F
+	};
+	return cutoff[rate & 0x0F];
+}
+
+// Sets the high-pass filter mode and cutoff. The filter only affects the
+// output once selected with setOutput().
+void L3G4200D::setHighPass(HighPassMode_t mode, uint8_t cutoff)
+{
+	if( cutoff > L3G4200D_HPCF_MAX ) {
+		cutoff = L3G4200D_HPCF_MAX;
+	}
+	writeReg(L3G4200D_CTRL_REG2, (mode << 4) | cutoff);
+}
 
+// Selects the filters between the sensor and the output registers,
+// leaving the FIFO and INT1 settings in CTRL_REG5 alone
+void L3G4200D::setOutput(Output_t output, bool highPass)
+{
+	byte value = readReg(L3G4200D_CTRL_REG5) & ~(L3G4200D_HPEN | 0x03);
 
-// Reads the 3 gyro channels and stores them in vector g
-void L3G4200D::read()
+	if( highPass ) {
+		value |= L3G4200D_HPEN;
+	}
+	writeReg(L3G4200D_CTRL_REG5, value | output);
+}
+
+// High-pass cutoff in Hz. Each step down the HPCF table halves the
+// cutoff (roughly), and each doubling of the data rate shifts the table
+// along by one entry.
+float L3G4200D::highPassHz(Datarate_t rate, uint8_t cutoff)
 {
-	Wire.beginTransmission(GYR_ADDRESS);
-	// assert the MSB of the address to get the gyro 
-	// to do slave-transmit subaddress updating.
-	Wire.write(L3G4200D_OUT_X_L | (1 << 7)); 
-	Wire.endTransmission();
-	Wire.requestFrom(GYR_ADDRESS, 6);
+	static const float cutoffs[13] = {
+		56.0F, 30.0F, 15.0F, 8.0F, 4.0F, 2.0F, 1.0F,
+		0.5F, 0.2F, 0.1F, 0.05F, 0.02F, 0.01F
+	};
+
+	if( cutoff > L3G4200D_HPCF_MAX ) {
+		cutoff = L3G4200D_HPCF_MAX;
+	}
+	return cutoffs[cutoff + 3 - (rate >> 2)];
+}
 
-  // Wait for data to be available
-	while (Wire.available() < 6);
+// CTRL_REG1: DR/BW in the top four bits, normal mode, X, Y and Z enabled
+void L3G4200D::writeControl1()
+{
+	writeReg(L3G4200D_CTRL_REG1, (datarate << 4) | 0x0F);
+}
+
+// CTRL_REG4: BDU and full scale
+void L3G4200D::writeControl4()
+{
+	byte value = blockUpdate ? 0x80 : 0x00;
+
+	switch(range)
+	{
+    case RANGE_250DPS:
+		break;
+    case RANGE_500DPS:
+		value |= 0x10;
+		break;
+    case RANGE_2000DPS:
+		value |= 0x20;
+		break;
+	}
+	writeReg(L3G4200D_CTRL_REG4, value);
+}
+
+// Reads the 3 gyro channels and stores them in vector g and counts.
+// While the FIFO is enabled every output read would pop its oldest
+// entry, so nothing is read and SENSOR_BUS_NO_DATA is returned, use
+// readFifo() instead.
+uint8_t L3G4200D::read()
+{
+	if( fifoEnabled ) {
+		return SENSOR_BUS_NO_DATA;
+	}
+
+	// OUT_TEMP, STATUS_REG then the six output bytes
+	uint8_t buffer[8];
+	uint8_t *out = buffer + 2;
+	int16_t raw[3];
+
+	// With drift compensation, every so often the burst starts two
+	// registers early to pick up OUT_TEMP in the same transaction.
+	bool withTemperature = drift != NULL && drift->temperatureDue();
+
+	// The bus sets the auto increment (I2C) or multi-byte (SPI) flag
+	// on the sub-address for a burst read.
+	// On a failed read, or in new-data-only mode when there is no
+	// new sample, the last good sample is kept.
+	uint8_t result = checkNewData(L3G4200D_STATUS_REG, L3G4200D_ZYXDA, L3G4200D_ZYXOR);
+	if( result == SENSOR_BUS_OK ) {
+		if( withTemperature ) {
+			result = bus->readRegisters(L3G4200D_OUT_TEMP, buffer, 8);
+		} else {
+			result = bus->readRegisters(L3G4200D_OUT_X_L, out, 6);
+		}
+	}
+	if( result != SENSOR_BUS_OK ) {
+		return result;
+	}
 	
-	uint8_t xla = Wire.read();
-	uint8_t xha = Wire.read();
-	uint8_t yla = Wire.read();
-	uint8_t yha = Wire.read();
-	uint8_t zla = Wire.read();
-	uint8_t zha = Wire.read();
-
-	g.x = (xha << 8) | xla;
-	g.y = (yha << 8) | yla;
-	g.z = (zha << 8) | zla;
+	raw[0] = (int16_t)((out[1] << 8) | out[0]);
+	raw[1] = (int16_t)((out[3] << 8) | out[2]);
+	raw[2] = (int16_t)((out[5] << 8) | out[4]);
+
+	if( drift != NULL ) {
+		if( withTemperature ) {
+			drift->setTemperature((int8_t)buffer[0]);
+		}
+		drift->correct(raw);
+	}
+
+	memcpy(counts, raw, sizeof(counts));
+	g.x = raw[0];
+	g.y = raw[1];
+	g.z = raw[2];
 	
 	// Compensate values depending on the resolution
 	switch(range)
@@ -175,7 +372,47 @@ void L3G4200D::read()
       g.y *= L3G4200D_SENSITIVITY_2000DPS;
       g.z *= L3G4200D_SENSITIVITY_2000DPS;
       break;
-	}	
+	}
+	return SENSOR_BUS_OK;
+}
+
+// Provides the sensor_t data for this sensor
+void L3G4200D::getSensor(sensor_t *sensor)
+{
+	/* Clear the sensor_t object */
+	memset(sensor, 0, sizeof(sensor_t));
+
+	/* Insert the sensor name in the fixed length char array */
+	strncpy (sensor->name, "L3G4200D", sizeof(sensor->name) - 1);
+	sensor->name[sizeof(sensor->name)- 1] = 0;
+	sensor->version     = 1;
+	sensor->sensor_id   = deviceId;
+	sensor->type        = SENSOR_TYPE_GYROSCOPE;
+	sensor->min_delay   = 1000000L / datarateHz(datarate);
+	sensor->max_value   = 2000.0F * SENSORS_DPS_TO_RADS;
+	sensor->min_value   = -2000.0F * SENSORS_DPS_TO_RADS;
+	sensor->resolution  = L3G4200D_SENSITIVITY_250DPS * SENSORS_DPS_TO_RADS;
+}
+
+// Reads the gyro and returns the data as a sensors_event_t in rad/s,
+// returns the bus status
+uint8_t L3G4200D::getEvent(sensors_event_t *event)
+{
+	uint32_t started = micros();
+
+	/* Clear the event */
+	memset(event, 0, sizeof(sensors_event_t));
+
+	event->version   = sizeof(sensors_event_t);
+	event->sensor_id = deviceId;
+	event->type      = SENSOR_TYPE_GYROSCOPE;
+
+	uint8_t result = read();
+	event->gyro.x = g.x * SENSORS_DPS_TO_RADS;
+	event->gyro.y = g.y * SENSORS_DPS_TO_RADS;
+	event->gyro.z = g.z * SENSORS_DPS_TO_RADS;
+	stampEvent(event, started);
+	return result;
 }
 
 void L3G4200D::vector_cross(const vector *a,const vector *b, vector *out)
@@ -205,23 +442,15 @@ void L3G4200D::vector_normalize(vector *a)
 // Writes a gyro register
 void L3G4200D::writeReg(byte reg, byte value)
 {
-	Wire.beginTransmission(GYR_ADDRESS);
-	Wire.write(reg);
-	Wire.write(value);
-	Wire.endTransmission();
+	bus->writeRegisters(reg, &value, 1);
 }
 
 // Reads a gyro register
 byte L3G4200D::readReg(byte reg)
 {
-	byte value;
+	byte value = 0;
 	
-	Wire.beginTransmission(GYR_ADDRESS);
-	Wire.write(reg);
-	Wire.endTransmission();
-	Wire.requestFrom(GYR_ADDRESS, 1);
-	value = Wire.read();
-	Wire.endTransmission();
+	bus->readRegisters(reg, &value, 1);
 	
 	return value;
 }
\ No newline at end of file
@@ -19,6 +19,15 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define L3G4200D_h
 
 #include "Arduino.h" // for byte data type
+#include "Sensor.h"
+#include "L3G4200DDrift.h"
+
+// The Arduino two-wire interface uses a 7-bit number for the address, 
+// and sets the last bit correctly based on reads and writes
+#define L3G4200D_ADDRESS       (0xD2 >> 1)  // SDO high
+#define L3G4200D_ADDRESS_ALT   (0xD0 >> 1)  // SDO low
+#define L3G4200D_MAX_I2C_CLOCK 400000L
+#define L3G4200D_STARTUP_MS    10   // power-down to first sample at 100Hz
 
 // register addresses
 
@@ -40,6 +49,35 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define L3G4200D_REFERENCE     0x25
 #define L3G4200D_OUT_TEMP      0x26
 #define L3G4200D_STATUS_REG    0x27
+#define L3G4200D_ZYXDA         0x08   // STATUS_REG new X, Y and Z data
+#define L3G4200D_ZYXOR         0x80   // STATUS_REG X, Y and Z data overwritten
+#define L3G4200D_HPCF_MAX      9      // CTRL_REG2 slowest high-pass cutoff code
+#define L3G4200D_HPEN          0x10   // CTRL_REG5 high-pass filter enable
+#define L3G4200D_FIFO_EN       0x40   // CTRL_REG5 FIFO enable
+#define L3G4200D_I1_INT1       0x80   // CTRL_REG3 INT1 generator on the INT1 pin
+
+// FIFO_CTRL_REG FM2..0 modes
+#define L3G4200D_FIFO_BYPASS            0x00
+#define L3G4200D_FIFO_FIFO              0x20
+#define L3G4200D_FIFO_STREAM            0x40
+#define L3G4200D_FIFO_STREAM_TO_FIFO    0x60
+#define L3G4200D_FIFO_BYPASS_TO_STREAM  0x80
+
+#define L3G4200D_FIFO_SIZE     32     // samples
+#define L3G4200D_FIFO_OVRN     0x40   // FIFO_SRC_REG full
+#define L3G4200D_FIFO_FSS      0x1F   // FIFO_SRC_REG stored samples
+#define L3G4200D_FIFO_BURST    5      // samples per burst, 30 bytes fits the Wire buffer
+
+// INT1_CFG axis events, OR'd together unless L3G4200D_INT1_AND is set
+#define L3G4200D_INT1_XLIE     0x01
+#define L3G4200D_INT1_XHIE     0x02
+#define L3G4200D_INT1_YLIE     0x04
+#define L3G4200D_INT1_YHIE     0x08
+#define L3G4200D_INT1_ZLIE     0x10
+#define L3G4200D_INT1_ZHIE     0x20
+#define L3G4200D_INT1_LIR      0x40   // latch until INT1_SRC is read
+#define L3G4200D_INT1_AND      0x80
+#define L3G4200D_INT1_WAIT     0x80   // INT1_DURATION wait before clearing
 
 #define L3G4200D_OUT_X_L       0x28
 #define L3G4200D_OUT_X_H       0x29
@@ -61,17 +99,64 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define L3G4200D_INT1_THS_ZL   0x37
 #define L3G4200D_INT1_DURATION 0x38
 
-class L3G4200D
+class L3G4200D : public Sensor
 {
 	
 		
 	public:
+		L3G4200D(int32_t sensorID = -1, uint8_t address = L3G4200D_ADDRESS)
+			: Sensor(address, sensorID, SENSOR_I2C_AUTOINC) {
+			range = RANGE_250DPS;
+			datarate = DATARATE_100HZ_12_5;
+			blockUpdate = true;
+			drift = NULL;
+			fifoEnabled = false;
+			memset(counts, 0, sizeof(counts));
+			i2c.setMaxClock(L3G4200D_MAX_I2C_CLOCK);
+		};
+
 	    typedef enum
 		{
 			RANGE_250DPS,
 			RANGE_500DPS,
 			RANGE_2000DPS
 		} Range_t;
+
+		// Output data rate and low-pass cutoff, the CTRL_REG1 DR1/0 and BW1/0 bits
+		typedef enum
+		{
+			DATARATE_100HZ_12_5 = 0x0,
+			DATARATE_100HZ_25   = 0x1,
+			DATARATE_200HZ_12_5 = 0x4,
+			DATARATE_200HZ_25   = 0x5,
+			DATARATE_200HZ_50   = 0x6,
+			DATARATE_200HZ_70   = 0x7,
+			DATARATE_400HZ_20   = 0x8,
+			DATARATE_400HZ_25   = 0x9,
+			DATARATE_400HZ_50   = 0xA,
+			DATARATE_400HZ_110  = 0xB,
+			DATARATE_800HZ_30   = 0xC,
+			DATARATE_800HZ_35   = 0xD,
+			DATARATE_800HZ_50   = 0xE,
+			DATARATE_800HZ_110  = 0xF
+		} Datarate_t;
+
+		// High-pass filter mode, the CTRL_REG2 HPM1/0 bits
+		typedef enum
+		{
+			HPF_NORMAL_RESET = 0x0,  // normal, reset by reading REFERENCE
+			HPF_REFERENCE    = 0x1,  // output relative to REFERENCE
+			HPF_NORMAL       = 0x2,
+			HPF_AUTORESET    = 0x3   // reset on an interrupt event
+		} HighPassMode_t;
+
+		// Output path, the CTRL_REG5 OUT_SEL bits. LPF1 is always applied.
+		typedef enum
+		{
+			OUTPUT_LPF1 = 0x0,  // no further filtering (default)
+			OUTPUT_HPF  = 0x1,  // after the high-pass filter
+			OUTPUT_LPF2 = 0x2   // after LPF2, and the high-pass filter if enabled
+		} Output_t;
 	
 		typedef struct vector
 		{
@@ -79,13 +164,36 @@ class L3G4200D
 		} vector;
 		
 		vector g; // gyro angular velocity readings
+		int16_t counts[3]; // the same reading in raw counts, for fixed-point users
 
 		
-		bool setup(Range_t rng);
+		bool setup(Range_t rng, Datarate_t rate = DATARATE_100HZ_12_5, bool bdu = true);
+		void setDatarate(Datarate_t rate);
+		Datarate_t getDatarate() { return datarate; };
+		void setBlockDataUpdate(bool enable);
+		static uint16_t datarateHz(Datarate_t rate);
+		static float bandwidthHz(Datarate_t rate);
+
+		// On-chip filtering, cutoff is the HPCF code 0 (highest) to 9
+		void setHighPass(HighPassMode_t mode, uint8_t cutoff);
+		void setOutput(Output_t output, bool highPass);
+		static float highPassHz(Datarate_t rate, uint8_t cutoff);
+
+		void setDriftCompensation(L3G4200DDrift *model);
+
+		// FIFO and INT1 threshold interrupt, samples are raw counts
+		void setFifoMode(byte mode);
+		uint8_t getFifoCount();
+		uint8_t readFifo(int16_t (*xyz)[3], uint8_t count);
+		void setThresholdInterrupt(byte events, uint16_t threshold, byte duration);
+		byte getInterruptSource();
 		void writeReg(byte reg, byte value);
 		byte readReg(byte reg);
 		
-		void read(void);
+		uint8_t read(void);
+		
+		uint8_t getEvent(sensors_event_t*);
+		void getSensor(sensor_t*);
 		
 		// vector functions
 		static void vector_cross(const vector *a, const vector *b, vector *out);
@@ -93,8 +201,14 @@ class L3G4200D
 		static void vector_normalize(vector *a);
 		
 	private:
-		byte address;
+		void writeControl1();
+		void writeControl4();
+
 		Range_t range;
+		Datarate_t datarate;
+		bool blockUpdate;
+		bool fifoEnabled;
+		L3G4200DDrift *drift;
 };
 
 #endif
@@ -0,0 +1,131 @@
+/*
+L3G4200DCapture.cpp - Threshold triggered FIFO capture for the L3G4200D.
+Copyright (C) 2013-2026 G.Pimblott and contributors
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the version 3 GNU General Public License as
+published by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include "L3G4200DCapture.h"
+
+L3G4200DCapture *L3G4200DCapture::attached = NULL;
+
+/************************************************************************/
+/*                                                                      */
+/************************************************************************/
+L3G4200DCapture::L3G4200DCapture(L3G4200D *gyro)
+{
+	this->gyro = gyro;
+	pin = 0;
+	post = 0;
+	periodMicros = 0;
+	triggered = false;
+	triggerTime = 0;
+}
+
+/************************************************************************/
+/* Set up the INT1 threshold (raw counts) on the given axis events and  */
+/* attach the ISR to the MCU pin INT1 is wired to. Captures run at the  */
+/* gyro's current data rate, set it with L3G4200D::setDatarate() first. */
+/************************************************************************/
+bool L3G4200DCapture::begin(uint8_t mcuPin, byte events, uint16_t threshold,
+                            byte duration, uint8_t postSamples)
+{
+	if( attached != NULL && attached != this ) {
+		return false;
+	}
+
+	pin = mcuPin;
+	post = postSamples < L3G4200D_FIFO_SIZE ? postSamples : L3G4200D_FIFO_SIZE - 1;
+	periodMicros = 1000000L / L3G4200D::datarateHz(gyro->getDatarate());
+
+	gyro->setThresholdInterrupt(events, threshold, duration);
+
+	attached = this;
+	pinMode(pin, INPUT);
+	attachInterrupt(digitalPinToInterrupt(pin), isr, RISING);
+
+	arm();
+	return true;
+}
+
+/************************************************************************/
+/*                                                                      */
+/************************************************************************/
+void L3G4200DCapture::end()
+{
+	if( attached == this ) {
+		detachInterrupt(digitalPinToInterrupt(pin));
+		gyro->setThresholdInterrupt(0, 0, 0);
+		gyro->setFifoMode(L3G4200D_FIFO_BYPASS);
+		attached = NULL;
+	}
+}
+
+/************************************************************************/
+/* Empty the FIFO, restart streaming and clear any latched interrupt.   */
+/* triggered is cleared first: INT1 re-latching after INT1_SRC is read  */
+/* then raises an edge the ISR acts on, rather than one it ignores      */
+/* while the pin stays high.                                            */
+/************************************************************************/
+void L3G4200DCapture::arm()
+{
+	gyro->setFifoMode(L3G4200D_FIFO_BYPASS);
+	gyro->setFifoMode(L3G4200D_FIFO_STREAM);
+	triggered = false;
+	gyro->getInterruptSource();
+}
+
+/************************************************************************/
+/* Call from the main loop. True when capture holds a complete block,   */
+/* which happens postSamples sample periods after the trigger.          */
+/************************************************************************/
+bool L3G4200DCapture::poll(l3g4200d_capture_t *capture)
+{
+	if( !triggered ) {
+		return false;
+	}
+
+	noInterrupts();
+	uint32_t at = triggerTime;
+	interrupts();
+
+	if( micros() - at < post * periodMicros ) {
+		return false;
+	}
+
+	/* A full FIFO in FIFO mode stops collecting, freezing the block */
+	gyro->setFifoMode(L3G4200D_FIFO_FIFO);
+	uint32_t after = (micros() - at) / periodMicros;
+
+	capture->count = gyro->getFifoCount();
+	capture->timestamp = at;
+	capture->trigger = after < capture->count ? capture->count - after : 0;
+	capture->source = gyro->getInterruptSource();
+	if( gyro->readFifo(capture->xyz, capture->count) != SENSOR_BUS_OK ) {
+		capture->count = 0;
+	}
+
+	arm();
+	return true;
+}
+
+/************************************************************************/
+/*                                                                      */
+/************************************************************************/
+void L3G4200DCapture::isr()
+{
+	if( attached != NULL && !attached->triggered ) {
+		attached->triggered = true;
+		attached->triggerTime = micros();
+	}
+}
@@ -0,0 +1,78 @@
+/*
+L3G4200DCapture.h - Threshold triggered FIFO capture for the L3G4200D.
+Copyright (C) 2013-2026 G.Pimblott and contributors
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the version 3 GNU General Public License as
+published by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef L3G4200DCAPTURE_H_
+#define L3G4200DCAPTURE_H_
+
+#include "Arduino.h"
+#include "L3G4200D.h"
+
+/** One captured event, samples in raw counts */
+typedef struct
+{
+	int16_t  xyz[L3G4200D_FIFO_SIZE][3];  /**< oldest first */
+	uint8_t  count;      /**< samples in xyz */
+	uint8_t  trigger;    /**< index of the first sample after the trigger */
+	uint8_t  source;     /**< INT1_SRC, which axes crossed the threshold */
+	uint32_t timestamp;  /**< micros() when the INT1 pin fired */
+} l3g4200d_capture_t;
+
+/************************************************************************/
+/* Records short bursts of gyro data around a threshold event without  */
+/* streaming over the bus.                                              */
+/*                                                                      */
+/* The FIFO runs in stream mode, always holding the latest 32 samples. */
+/* When INT1 fires the ISR notes the time; once postSamples more have   */
+/* arrived poll() freezes the FIFO by switching it to FIFO mode, reads  */
+/* the whole block and re-arms. The block therefore holds the samples   */
+/* before the trigger as well as those after it, provided poll() runs  */
+/* within 32 - postSamples sample periods of the block being ready.     */
+/* Polled later, the oldest pre-trigger samples have been overwritten   */
+/* and trigger moves towards 0. At 800Hz with 8 samples after the       */
+/* trigger that is 30ms, so poll() must run faster than that.           */
+/*                                                                      */
+/* L3G4200D::read() returns SENSOR_BUS_NO_DATA while the FIFO is on, as */
+/* every direct read would pop a sample from the block being captured.  */
+/*                                                                      */
+/* Only one instance can be attached, as the ISR is a plain function.  */
+/************************************************************************/
+class L3G4200DCapture {
+	public:
+	L3G4200DCapture(L3G4200D *gyro);
+
+	bool begin(uint8_t mcuPin, byte events, uint16_t threshold,
+	           byte duration = 0, uint8_t postSamples = L3G4200D_FIFO_SIZE / 2);
+	void end();
+
+	bool isTriggered() { return triggered; };
+	bool poll(l3g4200d_capture_t *capture);
+	void arm();
+
+	private:
+	static void isr();
+	static L3G4200DCapture *attached;
+
+	L3G4200D *gyro;
+	uint8_t pin;
+	uint8_t post;
+	uint32_t periodMicros;
+	volatile bool triggered;
+	volatile uint32_t triggerTime;
+};
+
+#endif /* L3G4200DCAPTURE_H_ */
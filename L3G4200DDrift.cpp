@@ -0,0 +1,205 @@
+/*
+L3G4200D temperature drift compensation.
+Copyright (C) 2013-2026 G.Pimblott and contributors
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the version 3 GNU General Public License as
+published by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include "L3G4200DDrift.h"
+
+/* Table position of a temperature, in degrees from the start of bin 0 */
+#define DRIFT_SPAN (L3G4200D_DRIFT_BINS * L3G4200D_DRIFT_BIN_WIDTH)
+
+/************************************************************************/
+/*                                                                      */
+/************************************************************************/
+L3G4200DDrift::L3G4200DDrift()
+{
+	clear();
+}
+
+/************************************************************************/
+/* Forget everything learned                                            */
+/************************************************************************/
+void L3G4200DDrift::clear()
+{
+	memset(bias, 0, sizeof(bias));
+	memset(weight, 0, sizeof(weight));
+	temperature = 0;
+	base = 0;
+	haveTemperature = false;
+	haveMean = false;
+	stillCount = 0;
+	sinceTemperature = L3G4200D_DRIFT_TEMP_INTERVAL;
+}
+
+/************************************************************************/
+/* True when the next read should include OUT_TEMP. Only reads passed  */
+/* to correct() count, so a read that fetched nothing doesn't use it up */
+/************************************************************************/
+bool L3G4200DDrift::temperatureDue()
+{
+	return sinceTemperature >= L3G4200D_DRIFT_TEMP_INTERVAL;
+}
+
+/************************************************************************/
+/* OUT_TEMP falls by one count per degree, the sign is flipped here so  */
+/* the table runs from cold to hot                                      */
+/************************************************************************/
+void L3G4200DDrift::setTemperature(int8_t outTemp)
+{
+	temperature = -outTemp;
+	sinceTemperature = 0;
+	if( !haveTemperature ) {
+		base = temperature;
+		haveTemperature = true;
+	}
+}
+
+/************************************************************************/
+/* Learn from a raw reading if the gyro is still, then subtract the     */
+/* bias for the current temperature in place                            */
+/************************************************************************/
+void L3G4200DDrift::correct(int16_t *xyz)
+{
+	int32_t offset[3];
+	bool still = true;
+
+	if( sinceTemperature < L3G4200D_DRIFT_TEMP_INTERVAL ) {
+		sinceTemperature++;
+	}
+
+	if( !haveMean ) {
+		for(uint8_t i = 0; i < 3; i++) {
+			mean[i] = (int32_t)xyz[i] << 4;
+		}
+		haveMean = true;
+	}
+
+	/* A short running mean, the gyro is still while every axis stays close */
+	for(uint8_t i = 0; i < 3; i++) {
+		int32_t sample = (int32_t)xyz[i] << 4;
+		int32_t deviation = sample - mean[i];
+
+		mean[i] += deviation / 8;
+		if( deviation > (L3G4200D_DRIFT_STILL_COUNTS << 4) || deviation < -(L3G4200D_DRIFT_STILL_COUNTS << 4) ) {
+			still = false;
+		}
+	}
+
+	if( !still ) {
+		stillCount = 0;
+	} else if( stillCount < L3G4200D_DRIFT_STILL_SAMPLES ) {
+		stillCount++;
+	}
+
+	if( !haveTemperature ) {
+		return;
+	}
+	if( isStill() ) {
+		learn(xyz);
+	}
+
+	if( interpolate(offset) ) {
+		for(uint8_t i = 0; i < 3; i++) {
+			xyz[i] -= (int16_t)((offset[i] + 8) >> 4);
+		}
+	}
+}
+
+/************************************************************************/
+/* Bias at the current temperature in raw counts, false if none learned */
+/************************************************************************/
+bool L3G4200DDrift::getBias(int16_t *xyz)
+{
+	int32_t offset[3];
+
+	if( !haveTemperature || !interpolate(offset) ) {
+		return false;
+	}
+	for(uint8_t i = 0; i < 3; i++) {
+		xyz[i] = (int16_t)((offset[i] + 8) >> 4);
+	}
+	return true;
+}
+
+/************************************************************************/
+/* Average the reading into the entry for the current temperature       */
+/************************************************************************/
+void L3G4200DDrift::learn(const int16_t *xyz)
+{
+	int16_t position = temperature - base + DRIFT_SPAN / 2;
+
+	if( position < 0 || position >= DRIFT_SPAN ) {
+		return;
+	}
+
+	for(uint8_t i = 0; i < 3; i++) {
+		if( xyz[i] > L3G4200D_DRIFT_MAX_BIAS || xyz[i] < -L3G4200D_DRIFT_MAX_BIAS ) {
+			return;
+		}
+	}
+
+	uint8_t entry = position / L3G4200D_DRIFT_BIN_WIDTH;
+	if( weight[entry] < L3G4200D_DRIFT_LEARN_WEIGHT ) {
+		weight[entry]++;
+	}
+	for(uint8_t i = 0; i < 3; i++) {
+		int32_t sample = (int32_t)xyz[i] << 4;
+		bias[entry][i] += (sample - bias[entry][i]) / weight[entry];
+	}
+}
+
+/************************************************************************/
+/* Linear interpolation between the nearest learned entries either side */
+/* of the current temperature, or the nearest one if only one side has  */
+/* been learned                                                         */
+/************************************************************************/
+bool L3G4200DDrift::interpolate(int32_t *xyz)
+{
+	/* Positions in units of half a degree so entry centres are whole numbers */
+	int16_t position = 2 * (temperature - base + DRIFT_SPAN / 2);
+	int8_t below = -1;
+	int8_t above = -1;
+
+	for(uint8_t entry = 0; entry < L3G4200D_DRIFT_BINS; entry++) {
+		int16_t centre = (2 * entry + 1) * L3G4200D_DRIFT_BIN_WIDTH;
+
+		if( weight[entry] == 0 ) {
+			continue;
+		}
+		if( centre <= position ) {
+			below = entry;
+		} else if( above < 0 ) {
+			above = entry;
+		}
+	}
+
+	if( below < 0 && above < 0 ) {
+		return false;
+	}
+	if( below < 0 || above < 0 ) {
+		uint8_t entry = below < 0 ? above : below;
+		for(uint8_t i = 0; i < 3; i++) {
+			xyz[i] = bias[entry][i];
+		}
+		return true;
+	}
+
+	int16_t low = (2 * below + 1) * L3G4200D_DRIFT_BIN_WIDTH;
+	int16_t span = (2 * above + 1) * L3G4200D_DRIFT_BIN_WIDTH - low;
+	for(uint8_t i = 0; i < 3; i++) {
+		xyz[i] = bias[below][i] + (int32_t)(bias[above][i] - bias[below][i]) * (position - low) / span;
+	}
+	return true;
+}
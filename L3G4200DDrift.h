@@ -0,0 +1,70 @@
+/*
+Header file for the L3G4200D temperature drift compensation.
+Copyright (C) 2013-2026 G.Pimblott and contributors
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the version 3 GNU General Public License as
+published by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef L3G4200DDRIFT_H_
+#define L3G4200DDRIFT_H_
+
+#include "Arduino.h"
+
+#define L3G4200D_DRIFT_BINS           16  // bias table entries
+#define L3G4200D_DRIFT_BIN_WIDTH      4   // degrees C per entry, 64C span
+#define L3G4200D_DRIFT_TEMP_INTERVAL  32  // reads between temperature samples
+#define L3G4200D_DRIFT_STILL_COUNTS   30  // deviation from the recent mean, ~0.26dps at 250dps
+#define L3G4200D_DRIFT_STILL_SAMPLES  50  // consecutive still reads before learning
+#define L3G4200D_DRIFT_LEARN_WEIGHT   64  // samples averaged per entry before it becomes a running average
+#define L3G4200D_DRIFT_MAX_BIAS       1143 // larger readings are rotation not bias, the 10dps zero-rate limit at 250dps
+
+/************************************************************************/
+/* Learns the gyro zero-rate level against the die temperature and      */
+/* removes it from each reading.                                        */
+/*                                                                      */
+/* OUT_TEMP has no fixed offset, so the table is centred on the first   */
+/* temperature seen. An entry is learned whenever the gyro has been     */
+/* still for a while at that temperature; between learned entries the   */
+/* bias is interpolated. All values are raw counts, kept in 1/16ths.    */
+/************************************************************************/
+class L3G4200DDrift {
+	public:
+	L3G4200DDrift();
+
+	void clear();
+
+	bool temperatureDue();
+	void setTemperature(int8_t outTemp);
+	void correct(int16_t *xyz);
+
+	int8_t getTemperature() { return temperature; };
+	bool isStill() { return stillCount >= L3G4200D_DRIFT_STILL_SAMPLES; };
+	bool getBias(int16_t *xyz);
+
+	private:
+	void learn(const int16_t *xyz);
+	bool interpolate(int32_t *xyz);
+
+	int16_t bias[L3G4200D_DRIFT_BINS][3];
+	uint8_t weight[L3G4200D_DRIFT_BINS];
+	int32_t mean[3];
+	int8_t temperature;
+	int8_t base;
+	bool haveTemperature;
+	bool haveMean;
+	uint8_t stillCount;
+	uint8_t sinceTemperature;
+};
+
+#endif /* L3G4200DDRIFT_H_ */
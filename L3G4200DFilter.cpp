@@ -0,0 +1,77 @@
+/*
+L3G4200D filter chain model.
+Copyright (C) 2013-2026 G.Pimblott and contributors
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the version 3 GNU General Public License as
+published by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include "L3G4200DFilter.h"
+
+/************************************************************************/
+/* Starts as a pass through, the chip's reset state                     */
+/************************************************************************/
+L3G4200DFilter::L3G4200DFilter()
+{
+	useHighPass = false;
+	useLowPass = false;
+	highAlpha = 1;
+	lowAlpha = 1;
+	reset();
+}
+
+/************************************************************************/
+/* Match L3G4200D::setDatarate(), setOutput() and setHighPass()         */
+/************************************************************************/
+void L3G4200DFilter::configure(L3G4200D::Datarate_t rate, L3G4200D::Output_t output,
+                               bool highPass, uint8_t cutoff)
+{
+	float dt = 1.0F / L3G4200D::datarateHz(rate);
+	float highRC = 1.0F / (2 * PI * L3G4200D::highPassHz(rate, cutoff));
+	float lowRC = 1.0F / (2 * PI * L3G4200D::bandwidthHz(rate));
+
+	useHighPass = output == L3G4200D::OUTPUT_HPF || (output == L3G4200D::OUTPUT_LPF2 && highPass);
+	useLowPass = output == L3G4200D::OUTPUT_LPF2;
+	highAlpha = highRC / (highRC + dt);
+	lowAlpha = dt / (lowRC + dt);
+	reset();
+}
+
+/************************************************************************/
+/* Settle the filters as if value had always been the input             */
+/************************************************************************/
+void L3G4200DFilter::reset(float value)
+{
+	lastInput = value;
+	highOut = 0;
+	lowOut = useHighPass ? 0 : value;
+}
+
+/************************************************************************/
+/* Run one sample through the chain, returns what the chip would output */
+/************************************************************************/
+float L3G4200DFilter::update(float input)
+{
+	float value = input;
+
+	if( useHighPass ) {
+		highOut = highAlpha * (highOut + input - lastInput);
+		value = highOut;
+	}
+	lastInput = input;
+
+	if( useLowPass ) {
+		lowOut += lowAlpha * (value - lowOut);
+		value = lowOut;
+	}
+	return value;
+}
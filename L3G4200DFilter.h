@@ -0,0 +1,49 @@
+/*
+Header file for the L3G4200D filter chain model.
+Copyright (C) 2013-2026 G.Pimblott and contributors
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the version 3 GNU General Public License as
+published by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef L3G4200DFILTER_H_
+#define L3G4200DFILTER_H_
+
+#include "L3G4200D.h"
+
+/************************************************************************/
+/* A first order model of the L3G4200D output filters after LPF1, set   */
+/* up the same way as the chip. Feeding it a test signal shows what a   */
+/* filter setting will do before committing to it, and its output can  */
+/* be compared with the chip's for the same input.                      */
+/************************************************************************/
+class L3G4200DFilter {
+	public:
+	L3G4200DFilter();
+
+	void configure(L3G4200D::Datarate_t rate, L3G4200D::Output_t output,
+	               bool highPass, uint8_t cutoff);
+	void reset(float value = 0);
+	float update(float input);
+
+	private:
+	bool useHighPass;
+	bool useLowPass;
+	float highAlpha;   /* RC / (RC + dt) at the high-pass cutoff */
+	float lowAlpha;    /* dt / (RC + dt) at the LPF2 cutoff */
+	float lastInput;
+	float highOut;
+	float lowOut;
+};
+
+#endif /* L3G4200DFILTER_H_ */
@@ -17,7 +17,6 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 Most of the credit goes to the ADAFruit unified sensor library which is available on GitHub
 
 */
-#include <Wire.h>
 #include "Sensor.h"
 
 /************************************************************************/
@@ -25,10 +24,7 @@ Most of the credit goes to the ADAFruit unified sensor library which is availabl
 /************************************************************************/
 void Sensor::updateI2C( int dataAddress, byte data)
 {
-	Wire.beginTransmission((uint8_t)deviceAddress);
-	Wire.write(dataAddress);
-	Wire.write(data);
-	Wire.endTransmission();
+	bus->writeRegisters((uint8_t)dataAddress, &data, 1);
 }
 
 /**************************************************************************/
@@ -36,35 +32,99 @@ void Sensor::updateI2C( int dataAddress, byte data)
 /**************************************************************************/
 void Sensor::writeCommand(byte reg, byte value)
 {
-  Wire.beginTransmission((uint8_t)deviceAddress);
-  Wire.write((uint8_t)reg);
-  Wire.write((uint8_t)value);
-  Wire.endTransmission();
+  bus->writeRegisters((uint8_t)reg, &value, 1);
 }
 
 /************************************************************************/
 /*                                                                      */
 /************************************************************************/
 void Sensor::writeI2C( byte data) {
-	Wire.beginTransmission((uint8_t)deviceAddress);
-	Wire.write(data);
-	Wire.endTransmission();
+	bus->write(&data, 1);
 }
 
 /************************************************************************/
 /*                                                                      */
 /************************************************************************/
 byte Sensor::readI2C() {
+	byte value = 0;
+	bus->read(&value, 1);
+	return value;
+}
 
-	Wire.requestFrom((uint8_t)deviceAddress, (uint8_t)1);
-	return Wire.read();
+/************************************************************************/
+/* Mark an event as read now. The latency runs from the DRDY edge given */
+/* to dataReady(), else from the status poll that found the data ready  */
+/* (the latest it can have become ready), else from readyMicros: when   */
+/* the read started, or when a conversion on command finished.          */
+/************************************************************************/
+void Sensor::stampEvent(sensors_event_t *event, uint32_t readyMicros)
+{
+	uint32_t ready = polled ? polledMicros : readyMicros;
+
+	/* An edge after the read started belongs to the next sample */
+	noInterrupts();
+	if( readyEdge && (int32_t)(readyMicros - edgeMicros) >= 0 ) {
+		ready = edgeMicros;
+		readyEdge = false;
+	}
+	interrupts();
+	polled = false;
+
+	event->latency = micros() - ready;
+	event->timestamp = millis();
+}
+
+/************************************************************************/
+/* In new-data-only mode read the status register and decide whether    */
+/* the outputs are worth reading. Returns SENSOR_BUS_OK to go ahead,    */
+/* SENSOR_BUS_NO_DATA, or the bus error from the status read.           */
+/************************************************************************/
+uint8_t Sensor::checkNewData(uint8_t statusReg, uint8_t readyMask, uint8_t overrunMask)
+{
+	uint8_t status;
+	uint8_t result;
+
+	stale = false;
+	polled = false;
+	if( !newDataOnly ) {
+		return SENSOR_BUS_OK;
+	}
+
+	uint32_t polledAt = micros();
+	result = bus->readRegisters(statusReg, &status, 1);
+	if( result != SENSOR_BUS_OK ) {
+		return result;
+	}
+
+	if( status & overrunMask ) {
+		overruns++;
+	}
+	if( !(status & readyMask) ) {
+		stale = true;
+		return SENSOR_BUS_NO_DATA;
+	}
+	polled = true;
+	polledMicros = polledAt;
+	return SENSOR_BUS_OK;
+}
+
+/************************************************************************/
+/* Status for getEvent: any bus error, else whether the sample is new   */
+/************************************************************************/
+uint8_t Sensor::eventStatus()
+{
+	uint8_t result = bus->getError();
+
+	if( result == SENSOR_BUS_OK && stale ) {
+		return SENSOR_BUS_NO_DATA;
+	}
+	return result;
 }
 
 byte Sensor::readWhoI2C() {
 	writeI2C( (byte)0 );
 	delay(100);
-	Wire.requestFrom((uint8_t)deviceAddress, (uint8_t)1);
-	return Wire.read();
+	return readI2C();
 }
 
 /**************************************************************************/
@@ -72,12 +132,7 @@ byte Sensor::readWhoI2C() {
 /**************************************************************************/
 void Sensor::read8(byte reg, uint8_t *value)
 {
-  Wire.beginTransmission((uint8_t)deviceAddress);
-  Wire.write((uint8_t)reg);
-  Wire.endTransmission();
-  Wire.requestFrom((uint8_t)deviceAddress, (byte)1);
-  *value = Wire.read(); 
-  Wire.endTransmission();
+  bus->readRegisters((uint8_t)reg, value, 1);
 }
 
 /**************************************************************************/
@@ -85,12 +140,9 @@ void Sensor::read8(byte reg, uint8_t *value)
 /**************************************************************************/
 void Sensor::read16(byte reg, uint16_t *value)
 {
-  Wire.beginTransmission((uint8_t)deviceAddress);
-  Wire.write((uint8_t)reg);
-  Wire.endTransmission();
-  Wire.requestFrom((uint8_t)deviceAddress, (byte)2);
-  *value = (Wire.read() << 8) | Wire.read();
-  Wire.endTransmission();
+  uint8_t buffer[2];
+  bus->readRegisters((uint8_t)reg, buffer, 2);
+  *value = (buffer[0] << 8) | buffer[1];
 }
 
 
@@ -101,4 +153,12 @@ void Sensor::readS16(byte reg, int16_t *value)
   uint16_t i;
   read16(reg, &i);
   *value = (int16_t)i;
-}
\ No newline at end of file
+}
+
+/**************************************************************************/
+/* Burst read consecutive registers                                       */
+/**************************************************************************/
+void Sensor::readBytes(byte reg, uint8_t *buffer, uint8_t len)
+{
+  bus->readRegisters((uint8_t)reg, buffer, len);
+}
@@ -22,6 +22,7 @@ Most of the credit goes to the ADAFruit unified sensor library which is availabl
 #define SENSOR_H_
 
 #include "Arduino.h"
+#include "SensorBus.h"
 
 /* Constants */
 #define SENSORS_GRAVITY_EARTH (9.80665F) /**< Earth's gravity in m/s^2 */
@@ -95,8 +96,8 @@ typedef struct
 	int32_t version; /**< must be sizeof(struct sensors_event_t) */
 	int32_t sensor_id; /**< unique sensor identifier */
 	int32_t type; /**< sensor type */
-	int32_t reserved0; /**< reserved */
-	int32_t timestamp; /**< time is in milliseconds */
+	int32_t latency; /**< microseconds from data-ready to the end of the read */
+	int32_t timestamp; /**< time is in milliseconds, taken when the read completed */
 	union
 	{
 		float data[4];
@@ -135,11 +136,30 @@ typedef struct
 class Sensor {
 	public:
 	// Constructor(s)
-	Sensor(uint8_t da, int32_t di)
+	Sensor(uint8_t da, int32_t di, uint8_t autoIncrement = 0) : i2c(da, autoIncrement)
 	{
 		deviceAddress = da;
 		deviceId = di;
+		bus = &i2c;
+		newDataOnly = false;
+		stale = false;
+		overruns = 0;
+		readyEdge = false;
+		edgeMicros = 0;
+		polled = false;
+		polledMicros = 0;
 	};
+	virtual ~Sensor() {};
+
+	// Replace the default I2C transport, e.g. with an SPIBus, before setup
+	void setBus(SensorBus *b) { bus = b; };
+	SensorBus *getBus() { return bus; };
+
+#ifdef SENSOR_BUS_STATS
+	// Transaction counters for this device, see SENSOR_BUS_STATS
+	const sensor_bus_stats_t *getStats() { return bus->getStats(); };
+	void resetStats() { bus->resetStats(); };
+#endif
 
 	void writeI2C( byte data);
 	byte readI2C();
@@ -150,15 +170,44 @@ class Sensor {
 	void read8(byte reg, uint8_t *value);
 	void read16(byte reg, uint16_t *value);
 	void readS16(byte reg, int16_t *value);
+	void readBytes(byte reg, uint8_t *buffer, uint8_t len);
 	
 
-	// These must be defined by the subclass
-	virtual void getEvent(sensors_event_t*);
-	virtual void getSensor(sensor_t*);
+	// Check the device status register before each read and skip the
+	// read (returning SENSOR_BUS_NO_DATA) when there is no new sample
+	void setNewDataOnly(bool enable) { newDataOnly = enable; stale = false; };
+	bool isNewDataOnly() { return newDataOnly; };
+	// Samples the device overwrote before they were read, new-data-only mode
+	uint16_t getOverruns() { return overruns; };
+	void clearOverruns() { overruns = 0; };
+
+	// Call from an interrupt on the device's DRDY pin, the next event's
+	// latency is then measured from this edge
+	void dataReady() { edgeMicros = micros(); readyEdge = true; };
+
+	// These must be defined by the subclass, getEvent returns the bus
+	// status (SENSOR_BUS_OK when the event holds a fresh reading)
+	virtual uint8_t getEvent(sensors_event_t*) = 0;
+	virtual void getSensor(sensor_t*) = 0;
 	
 	protected:
+	void stampEvent(sensors_event_t *event, uint32_t readyMicros);
+	uint8_t checkNewData(uint8_t statusReg, uint8_t readyMask, uint8_t overrunMask);
+	uint8_t eventStatus();
+
 	uint8_t deviceAddress;
 	int32_t deviceId;
+	I2CBus i2c;
+	SensorBus *bus;
+
+	bool newDataOnly;
+	bool stale;        /* the last read found no new sample */
+	uint16_t overruns;
+
+	volatile bool readyEdge;       /* dataReady() since the last event */
+	volatile uint32_t edgeMicros;
+	bool polled;                   /* the status poll of this read saw new data */
+	uint32_t polledMicros;
 };
 
 
@@ -0,0 +1,153 @@
+/*
+Multi-sensor time alignment stage.
+Copyright (C) 2013-2026 G.Pimblott and contributors
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the version 3 GNU General Public License as
+published by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include "SensorAlign.h"
+
+/* Samples per channel in each component of a frame */
+static const uint8_t widths[SENSOR_ALIGN_CHANNELS] = { 3, 3, 3, 1 };
+
+/************************************************************************/
+/* Frames every periodMicros, delayMicros behind the time passed to     */
+/* next()                                                               */
+/************************************************************************/
+SensorAlign::SensorAlign(uint32_t periodMicros, uint32_t delayMicros)
+{
+	period = periodMicros;
+	lag = delayMicros;
+	reset();
+}
+
+/************************************************************************/
+/*                                                                      */
+/************************************************************************/
+void SensorAlign::reset()
+{
+	tick = 0;
+	started = false;
+	memset(history, 0, sizeof(history));
+	memset(head, 0, sizeof(head));
+	memset(count, 0, sizeof(count));
+}
+
+/************************************************************************/
+/* Add a sample taken at sampleMicros. Samples must be pushed in time   */
+/* order per channel; pressure uses values[0] only.                     */
+/************************************************************************/
+void SensorAlign::push(uint8_t channel, const float *values, uint32_t sampleMicros)
+{
+	if( channel >= SENSOR_ALIGN_CHANNELS ) {
+		return;
+	}
+
+	sample_t *s = &history[channel][head[channel]];
+	s->time = sampleMicros;
+	memcpy(s->v, values, widths[channel] * sizeof(float));
+
+	head[channel] = (head[channel] + 1) % SENSOR_ALIGN_HISTORY;
+	if( count[channel] < SENSOR_ALIGN_HISTORY ) {
+		count[channel]++;
+	}
+}
+
+/************************************************************************/
+/* Add an event straight after getEvent(), dating it back by the        */
+/* event's latency to when the device produced it                       */
+/************************************************************************/
+void SensorAlign::push(uint8_t channel, const sensors_event_t *event)
+{
+	push(channel, event->data, micros() - (uint32_t)event->latency);
+}
+
+/************************************************************************/
+/* Value of a channel at the given time. Returns 1 when interpolated    */
+/* between two samples, 0 when held from the nearest one or missing.    */
+/************************************************************************/
+uint8_t SensorAlign::sample(uint8_t channel, uint32_t at, float *out)
+{
+	uint8_t n = count[channel];
+	uint8_t width = widths[channel];
+
+	if( n == 0 ) {
+		memset(out, 0, width * sizeof(float));
+		return 0;
+	}
+
+	// Walk back from the newest sample to the first one at or before the
+	// frame time, differences taken signed so micros() may wrap
+	uint8_t newest = (head[channel] + SENSOR_ALIGN_HISTORY - 1) % SENSOR_ALIGN_HISTORY;
+	const sample_t *after = NULL;
+	const sample_t *before = &history[channel][newest];
+
+	for(uint8_t i = 1; i < n && (int32_t)(before->time - at) > 0; i++) {
+		after = before;
+		before = &history[channel][(newest + SENSOR_ALIGN_HISTORY - i) % SENSOR_ALIGN_HISTORY];
+	}
+
+	if( after == NULL || (int32_t)(before->time - at) > 0 ) {
+		// Nothing newer than the frame, or nothing old enough
+		memcpy(out, before->v, width * sizeof(float));
+		return 0;
+	}
+
+	float span = (float)(after->time - before->time);
+	float f = span > 0 ? (float)(at - before->time) / span : 0;
+	for(uint8_t i = 0; i < width; i++) {
+		out[i] = before->v[i] + (after->v[i] - before->v[i]) * f;
+	}
+	return 1;
+}
+
+/************************************************************************/
+/* Fill in the next frame if its time has come, call until it returns   */
+/* false. Nothing is emitted before the first push. Skips ahead rather  */
+/* than emitting a backlog older than the history can cover.            */
+/************************************************************************/
+bool SensorAlign::next(sensor_frame_t *frame, uint32_t now)
+{
+	uint32_t due = now - lag;
+
+	if( !started && count[SENSOR_ALIGN_GYRO] + count[SENSOR_ALIGN_ACCEL] +
+	    count[SENSOR_ALIGN_MAGNETIC] + count[SENSOR_ALIGN_PRESSURE] == 0 ) {
+		return false;
+	}
+	if( !started || (int32_t)(due - tick) > (int32_t)(period * SENSOR_ALIGN_HISTORY) ) {
+		tick = due;
+		started = true;
+	}
+	if( (int32_t)(due - tick) < 0 ) {
+		return false;
+	}
+
+	// The frame is packed, so fill it through a buffer rather than
+	// handing out pointers to its members
+	float v[3];
+	uint8_t interpolated = 0;
+
+	frame->timestamp = tick;
+	interpolated |= sample(SENSOR_ALIGN_GYRO, tick, v) << SENSOR_ALIGN_GYRO;
+	memcpy(frame->gyro, v, sizeof(frame->gyro));
+	interpolated |= sample(SENSOR_ALIGN_ACCEL, tick, v) << SENSOR_ALIGN_ACCEL;
+	memcpy(frame->accel, v, sizeof(frame->accel));
+	interpolated |= sample(SENSOR_ALIGN_MAGNETIC, tick, v) << SENSOR_ALIGN_MAGNETIC;
+	memcpy(frame->magnetic, v, sizeof(frame->magnetic));
+	interpolated |= sample(SENSOR_ALIGN_PRESSURE, tick, v) << SENSOR_ALIGN_PRESSURE;
+	frame->pressure = v[0];
+	frame->interpolated = interpolated;
+
+	tick += period;
+	return true;
+}
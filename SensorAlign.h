@@ -0,0 +1,88 @@
+/*
+Header file for the multi-sensor time alignment stage.
+Copyright (C) 2013-2026 G.Pimblott and contributors
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the version 3 GNU General Public License as
+published by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef SENSORALIGN_H_
+#define SENSORALIGN_H_
+
+#include "Arduino.h"
+#include "Sensor.h"
+
+/* Samples kept per channel, 16 bytes each */
+#define SENSOR_ALIGN_HISTORY 4
+
+/** Channels of an aligned frame */
+typedef enum
+{
+	SENSOR_ALIGN_GYRO = 0,
+	SENSOR_ALIGN_ACCEL = 1,
+	SENSOR_ALIGN_MAGNETIC = 2,
+	SENSOR_ALIGN_PRESSURE = 3,
+	SENSOR_ALIGN_CHANNELS = 4
+} sensor_align_channel_t;
+
+/** One aligned record per tick, in the units the samples were pushed in */
+typedef struct __attribute__((packed))
+{
+	uint32_t timestamp;    /**< micros() the frame describes */
+	float gyro[3];
+	float accel[3];
+	float magnetic[3];
+	float pressure;
+	uint8_t interpolated;  /**< bit per channel, clear when the value is held or missing */
+} sensor_frame_t;
+
+/************************************************************************/
+/* Resamples sensors read at different instants onto a common timebase. */
+/*                                                                      */
+/* Each read is pushed with the time it was sampled. Frames are emitted */
+/* at a fixed rate, delayMicros behind the present so that every        */
+/* channel has normally been read on both sides of the frame time, and  */
+/* each channel is linearly interpolated between those two samples.     */
+/* A channel with nothing newer than the frame holds its latest value   */
+/* and has its interpolated bit cleared. A channel never pushed is zero.*/
+/*                                                                      */
+/* The delay should cover the slowest channel's read interval.          */
+/************************************************************************/
+class SensorAlign {
+	public:
+	SensorAlign(uint32_t periodMicros, uint32_t delayMicros);
+
+	void push(uint8_t channel, const float *values, uint32_t sampleMicros);
+	void push(uint8_t channel, const sensors_event_t *event);
+	bool next(sensor_frame_t *frame, uint32_t now);
+	void reset();
+
+	private:
+	typedef struct
+	{
+		uint32_t time;
+		float v[3];
+	} sample_t;
+
+	uint8_t sample(uint8_t channel, uint32_t at, float *out);
+
+	uint32_t period;
+	uint32_t lag;
+	uint32_t tick;
+	bool started;
+	sample_t history[SENSOR_ALIGN_CHANNELS][SENSOR_ALIGN_HISTORY];
+	uint8_t head[SENSOR_ALIGN_CHANNELS];   /* next slot to write */
+	uint8_t count[SENSOR_ALIGN_CHANNELS];
+};
+
+#endif /* SENSORALIGN_H_ */
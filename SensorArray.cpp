@@ -0,0 +1,64 @@
+/*
+Sensor array.
+Copyright (C) 2013-2026 G.Pimblott and contributors
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the version 3 GNU General Public License as
+published by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include "SensorArray.h"
+
+/************************************************************************/
+/* The array of sensor pointers is owned by the caller                  */
+/************************************************************************/
+SensorArray::SensorArray(Sensor **sensors, uint8_t count)
+{
+	this->sensors = sensors;
+	this->count = count;
+	current = 0;
+}
+
+/************************************************************************/
+/* Read the next device in turn, returns the index of the device read   */
+/* and optionally the bus status of the read                            */
+/************************************************************************/
+uint8_t SensorArray::next(sensors_event_t *event, uint8_t *status)
+{
+	uint8_t index = current;
+	uint8_t result = sensors[index]->getEvent(event);
+
+	if( status ) {
+		*status = result;
+	}
+
+	if( ++current >= count ) {
+		current = 0;
+	}
+	return index;
+}
+
+/************************************************************************/
+/* Read every device, events must have room for size() entries.        */
+/* Returns the first failure, the remaining devices are still read.     */
+/************************************************************************/
+uint8_t SensorArray::getEvents(sensors_event_t *events)
+{
+	uint8_t status = SENSOR_BUS_OK;
+
+	for(uint8_t i = 0; i < count; i++) {
+		uint8_t result = sensors[i]->getEvent(&events[i]);
+		if( status == SENSOR_BUS_OK ) {
+			status = result;
+		}
+	}
+	return status;
+}
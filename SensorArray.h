@@ -0,0 +1,45 @@
+/*
+Header file for the Sensor array.
+Copyright (C) 2013-2026 G.Pimblott and contributors
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the version 3 GNU General Public License as
+published by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef SENSORARRAY_H_
+#define SENSORARRAY_H_
+
+#include "Sensor.h"
+
+/************************************************************************/
+/* A group of identical sensors, e.g. a redundant pair of gyros at the  */
+/* primary and alternate addresses, serviced round-robin so each call   */
+/* costs one device read and every device is read at the same rate.     */
+/************************************************************************/
+class SensorArray {
+	public:
+	SensorArray(Sensor **sensors, uint8_t count);
+
+	uint8_t next(sensors_event_t *event, uint8_t *status = NULL);
+	uint8_t getEvents(sensors_event_t *events);
+
+	Sensor *get(uint8_t index) { return index < count ? sensors[index] : NULL; };
+	uint8_t size() { return count; };
+
+	protected:
+	Sensor **sensors;
+	uint8_t count;
+	uint8_t current;
+};
+
+#endif /* SENSORARRAY_H_ */
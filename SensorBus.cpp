@@ -0,0 +1,627 @@
+/*
+Sensor bus transports.
+Copyright (C) 2013-2026 G.Pimblott and contributors
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the version 3 GNU General Public License as
+published by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include <Wire.h>
+#include <SPI.h>
+#include "SensorBus.h"
+
+/* I2C framing: every byte is 8 bits plus an ACK, a start, repeated start  */
+/* or stop condition costs roughly one more bit time                       */
+#define I2C_BITS_PER_BYTE 9
+#define I2C_BITS_PER_CONDITION 1
+
+/* Time for chip select setup/hold around an SPI transfer */
+#define SPI_CS_MICROS 1
+
+/* Bus recovery: up to nine clocks to let a slave finish its byte, then a */
+/* stop condition, at roughly 100kHz                                      */
+#define I2C_RECOVERY_CLOCKS 9
+#define I2C_RECOVERY_HALF_PERIOD 5
+#define I2C_RECOVERY_MICROS ((I2C_RECOVERY_CLOCKS + 1) * 2 * I2C_RECOVERY_HALF_PERIOD)
+
+/* Wire.endTransmission() result when the transaction timed out */
+#define WIRE_TIMEOUT_RESULT 5
+
+/************************************************************************/
+/* Time on the wire for a number of I2C bit periods                     */
+/************************************************************************/
+uint32_t SensorBus::i2cMicros(uint32_t clock, uint16_t bits)
+{
+	return ((uint32_t)bits * 1000000L + clock - 1) / clock;
+}
+
+/************************************************************************/
+/* Time on the wire for a number of SPI bytes, including chip select    */
+/************************************************************************/
+uint32_t SensorBus::spiMicros(uint32_t clock, uint16_t bytes)
+{
+	return ((uint32_t)bytes * 8 * 1000000L + clock - 1) / clock + SPI_CS_MICROS;
+}
+
+#ifdef SENSOR_BUS_STATS
+/************************************************************************/
+/*                                                                      */
+/************************************************************************/
+void SensorBus::resetStats()
+{
+	memset(&stats, 0, sizeof(stats));
+	stats.minMicros = 0xFFFF;
+}
+
+/************************************************************************/
+/* Account for one finished transaction                                 */
+/************************************************************************/
+void SensorBus::count(uint8_t result, uint32_t elapsed, uint8_t bytes)
+{
+	uint16_t us = elapsed > 0xFFFF ? 0xFFFF : (uint16_t)elapsed;
+	uint8_t bin = 0;
+
+	stats.transactions++;
+	stats.bytes += bytes;
+	stats.micros += elapsed;
+	if( result != SENSOR_BUS_OK ) {
+		stats.errors++;
+	}
+
+	if( us < stats.minMicros ) {
+		stats.minMicros = us;
+	}
+	if( us > stats.maxMicros ) {
+		stats.maxMicros = us;
+	}
+
+	for(uint16_t limit = SENSOR_BUS_HISTOGRAM_BASE;
+	    bin < SENSOR_BUS_HISTOGRAM_BINS - 1 && us >= limit; limit <<= 1) {
+		bin++;
+	}
+	stats.histogram[bin]++;
+}
+#endif
+
+/**************************************************************************/
+/* I2C                                                                    */
+/**************************************************************************/
+
+bool I2CBus::started = false;
+uint32_t I2CBus::requestedClock = SENSOR_I2C_CLOCK;
+uint32_t I2CBus::limitClock = 0xFFFFFFFFUL;
+uint32_t I2CBus::busClock = SENSOR_I2C_CLOCK;
+uint32_t I2CBus::timeout = SENSOR_I2C_TIMEOUT;
+uint8_t I2CBus::retries = SENSOR_I2C_RETRIES;
+
+/************************************************************************/
+/* Select the bus clock (SENSOR_I2C_CLOCK or SENSOR_I2C_CLOCK_FAST).    */
+/* Call before the sensors are set up or at any time after.             */
+/************************************************************************/
+void I2CBus::setBusClock(uint32_t clock)
+{
+	requestedClock = clock;
+	if( started ) {
+		applyClock();
+	}
+}
+
+/************************************************************************/
+/* Join the shared bus, slowing it down if this device needs it         */
+/************************************************************************/
+void I2CBus::begin()
+{
+	if( maxClock < limitClock ) {
+		limitClock = maxClock;
+	}
+
+	if( !started ) {
+		startWire();
+	}
+	applyClock();
+}
+
+/************************************************************************/
+/* Check whether any device acknowledges the address                    */
+/************************************************************************/
+bool I2CBus::probe(uint8_t address)
+{
+	if( !started ) {
+		startWire();
+		applyClock();
+	}
+
+	Wire.beginTransmission(address);
+	return Wire.endTransmission() == 0;
+}
+
+/************************************************************************/
+/* Start the Wire library with the transaction deadline armed          */
+/************************************************************************/
+void I2CBus::startWire()
+{
+	Wire.begin();
+#ifdef WIRE_HAS_TIMEOUT
+	Wire.setWireTimeout(timeout, true);
+#endif
+	started = true;
+}
+
+/************************************************************************/
+/* Deadline for a single transaction in microseconds. Enforced by the   */
+/* Wire library on cores that provide WIRE_HAS_TIMEOUT.                 */
+/************************************************************************/
+void I2CBus::setTimeout(uint32_t micros)
+{
+	timeout = micros;
+#ifdef WIRE_HAS_TIMEOUT
+	if( started ) {
+		Wire.setWireTimeout(timeout, true);
+	}
+#endif
+}
+
+/************************************************************************/
+/* Longest any one call can block: every attempt timing out, with a     */
+/* recovery between each. A register read is a transmit and a receive   */
+/* and either can run to the timeout, so each attempt counts twice.     */
+/************************************************************************/
+uint32_t I2CBus::worstCaseMicros()
+{
+	return (retries + 1) * 2 * timeout + retries * (uint32_t)I2C_RECOVERY_MICROS;
+}
+
+/************************************************************************/
+/* Free a bus held by a slave that lost sync part way through a byte.   */
+/* SCL is clocked until the slave releases SDA then a stop is sent.     */
+/* Returns false if either line is still held low.                      */
+/************************************************************************/
+bool I2CBus::recover()
+{
+	Wire.end();
+
+	/* Open drain: drive low as an output, release as an input */
+	pinMode(SDA, INPUT);
+	pinMode(SCL, INPUT);
+	digitalWrite(SDA, LOW);
+	digitalWrite(SCL, LOW);
+
+	for(uint8_t i = 0; i < I2C_RECOVERY_CLOCKS && digitalRead(SDA) == LOW; i++) {
+		pinMode(SCL, OUTPUT);
+		delayMicroseconds(I2C_RECOVERY_HALF_PERIOD);
+		pinMode(SCL, INPUT);
+		delayMicroseconds(I2C_RECOVERY_HALF_PERIOD);
+	}
+
+	/* Stop: SDA rises while SCL is high */
+	pinMode(SDA, OUTPUT);
+	delayMicroseconds(I2C_RECOVERY_HALF_PERIOD);
+	pinMode(SDA, INPUT);
+	delayMicroseconds(I2C_RECOVERY_HALF_PERIOD);
+
+	bool released = digitalRead(SDA) == HIGH && digitalRead(SCL) == HIGH;
+
+	startWire();
+	applyClock();
+	return released;
+}
+
+/************************************************************************/
+/*                                                                      */
+/************************************************************************/
+void I2CBus::applyClock()
+{
+	busClock = requestedClock < limitClock ? requestedClock : limitClock;
+	Wire.setClock(busClock);
+}
+
+/************************************************************************/
+/* Percentage of the bus time a schedule would use at a given clock.    */
+/* The clock is limited to the slowest device in the schedule, so a     */
+/* configuration can be checked before it is deployed; anything over    */
+/* 100% cannot be sustained.                                            */
+/************************************************************************/
+float I2CBus::utilization(const i2c_schedule_t *schedule, uint8_t count, uint32_t clock)
+{
+	float busy = 0;
+
+	for(uint8_t i = 0; i < count; i++) {
+		if( schedule[i].maxClock < clock ) {
+			clock = schedule[i].maxClock;
+		}
+	}
+
+	for(uint8_t i = 0; i < count; i++) {
+		uint16_t bits = (3 + schedule[i].bytes) * I2C_BITS_PER_BYTE + 3 * I2C_BITS_PER_CONDITION;
+		busy += (float)i2cMicros(clock, bits) * schedule[i].reads * schedule[i].rate;
+	}
+
+	return busy / 10000.0F;  /* us per second to percent */
+}
+
+/************************************************************************/
+/* One write transaction: an optional prefix (the register) then data   */
+/************************************************************************/
+uint8_t I2CBus::transmit(const uint8_t *prefix, uint8_t prefixLen, const uint8_t *data, uint8_t len)
+{
+	Wire.beginTransmission(address);
+	for(uint8_t i = 0; i < prefixLen; i++) {
+		Wire.write(prefix[i]);
+	}
+	for(uint8_t i = 0; i < len; i++) {
+		Wire.write(data[i]);
+	}
+
+	switch( Wire.endTransmission() ) {
+		case 0:
+			return SENSOR_BUS_OK;
+		case WIRE_TIMEOUT_RESULT:
+			return SENSOR_BUS_TIMEOUT;
+		default:
+			return SENSOR_BUS_NACK;
+	}
+}
+
+/************************************************************************/
+/* One read transaction, a short read is never padded with stale bytes  */
+/************************************************************************/
+uint8_t I2CBus::receive(uint8_t *data, uint8_t len)
+{
+	uint8_t i = 0;
+
+	Wire.requestFrom(address, len);
+#ifdef WIRE_HAS_TIMEOUT
+	if( Wire.getWireTimeoutFlag() ) {
+		Wire.clearWireTimeoutFlag();
+		return SENSOR_BUS_TIMEOUT;
+	}
+#endif
+	while( Wire.available() && i < len ) {
+		data[i++] = Wire.read();
+	}
+
+	return i == len ? SENSOR_BUS_OK : SENSOR_BUS_SHORT_READ;
+}
+
+/************************************************************************/
+/* Decide whether a failed transaction is worth another attempt. After  */
+/* a timeout the bus is recovered first, if that fails there is no      */
+/* point retrying and the result becomes SENSOR_BUS_STUCK.              */
+/************************************************************************/
+bool I2CBus::again(uint8_t *result, uint8_t attempt)
+{
+	if( *result == SENSOR_BUS_OK || attempt >= retries ) {
+		return false;
+	}
+#ifdef SENSOR_BUS_STATS
+	stats.retries++;
+#endif
+
+	if( *result == SENSOR_BUS_TIMEOUT && !recover() ) {
+		*result = SENSOR_BUS_STUCK;
+		return false;
+	}
+	return true;
+}
+
+/************************************************************************/
+/* Write raw bytes (e.g. a register pointer) in a single transaction    */
+/************************************************************************/
+uint8_t I2CBus::write(const uint8_t *data, uint8_t len)
+{
+	uint8_t result;
+	uint8_t attempt = 0;
+	uint32_t start = stamp();
+
+	do {
+		result = transmit(NULL, 0, data, len);
+	} while( again(&result, attempt++) );
+
+	count(result, stamp() - start, len);
+	return record(result);
+}
+
+/************************************************************************/
+/* Read raw bytes from wherever the device register pointer is         */
+/************************************************************************/
+uint8_t I2CBus::read(uint8_t *data, uint8_t len)
+{
+	uint8_t result;
+	uint8_t attempt = 0;
+	uint32_t start = stamp();
+
+	do {
+		result = receive(data, len);
+	} while( again(&result, attempt++) );
+
+	count(result, stamp() - start, len);
+	return record(result);
+}
+
+/************************************************************************/
+/*                                                                      */
+/************************************************************************/
+uint8_t I2CBus::writeRegisters(uint8_t reg, const uint8_t *data, uint8_t len)
+{
+	uint8_t result;
+	uint8_t attempt = 0;
+	uint32_t start = stamp();
+
+	if( len > 1 ) {
+		reg |= autoIncrement;
+	}
+
+	do {
+		result = transmit(&reg, 1, data, len);
+	} while( again(&result, attempt++) );
+
+	count(result, stamp() - start, 1 + len);
+	return record(result);
+}
+
+/************************************************************************/
+/* Set the register pointer then burst read len bytes. A retry repeats  */
+/* both halves as the pointer may have moved.                           */
+/************************************************************************/
+uint8_t I2CBus::readRegisters(uint8_t reg, uint8_t *data, uint8_t len)
+{
+	uint8_t result;
+	uint8_t attempt = 0;
+	uint32_t start = stamp();
+
+	if( len > 1 ) {
+		reg |= autoIncrement;
+	}
+
+	do {
+		result = transmit(NULL, 0, &reg, 1);
+		if( result == SENSOR_BUS_OK ) {
+			result = receive(data, len);
+		}
+	} while( again(&result, attempt++) );
+
+	count(result, stamp() - start, 1 + len);
+	return record(result);
+}
+
+/************************************************************************/
+/* addr+W, reg, restart, addr+R, len bytes, stop                        */
+/************************************************************************/
+uint32_t I2CBus::readMicros(uint8_t len)
+{
+	return i2cMicros(busClock, (3 + len) * I2C_BITS_PER_BYTE + 3 * I2C_BITS_PER_CONDITION);
+}
+
+/************************************************************************/
+/* addr+W, reg, len bytes, stop                                         */
+/************************************************************************/
+uint32_t I2CBus::writeMicros(uint8_t len)
+{
+	return i2cMicros(busClock, (2 + len) * I2C_BITS_PER_BYTE + 2 * I2C_BITS_PER_CONDITION);
+}
+
+/**************************************************************************/
+/* SPI                                                                    */
+/**************************************************************************/
+
+void SPIBus::begin()
+{
+	pinMode(csPin, OUTPUT);
+	digitalWrite(csPin, HIGH);
+	SPI.begin();
+}
+
+/************************************************************************/
+/*                                                                      */
+/************************************************************************/
+uint8_t SPIBus::write(const uint8_t *data, uint8_t len)
+{
+	uint32_t start = stamp();
+
+	SPI.beginTransaction(SPISettings(clock, MSBFIRST, SPI_MODE3));
+	digitalWrite(csPin, LOW);
+	for(uint8_t i = 0; i < len; i++) {
+		SPI.transfer(data[i]);
+	}
+	digitalWrite(csPin, HIGH);
+	SPI.endTransaction();
+	count(SENSOR_BUS_OK, stamp() - start, len);
+	return SENSOR_BUS_OK;
+}
+
+/************************************************************************/
+/*                                                                      */
+/************************************************************************/
+uint8_t SPIBus::read(uint8_t *data, uint8_t len)
+{
+	uint32_t start = stamp();
+
+	SPI.beginTransaction(SPISettings(clock, MSBFIRST, SPI_MODE3));
+	digitalWrite(csPin, LOW);
+	for(uint8_t i = 0; i < len; i++) {
+		data[i] = SPI.transfer(0);
+	}
+	digitalWrite(csPin, HIGH);
+	SPI.endTransaction();
+	count(SENSOR_BUS_OK, stamp() - start, len);
+	return SENSOR_BUS_OK;
+}
+
+/************************************************************************/
+/*                                                                      */
+/************************************************************************/
+uint8_t SPIBus::writeRegisters(uint8_t reg, const uint8_t *data, uint8_t len)
+{
+	uint32_t start = stamp();
+
+	if( len > 1 ) {
+		reg |= multiByteFlag;
+	}
+
+	SPI.beginTransaction(SPISettings(clock, MSBFIRST, SPI_MODE3));
+	digitalWrite(csPin, LOW);
+	SPI.transfer(reg);
+	for(uint8_t i = 0; i < len; i++) {
+		SPI.transfer(data[i]);
+	}
+	digitalWrite(csPin, HIGH);
+	SPI.endTransaction();
+	count(SENSOR_BUS_OK, stamp() - start, 1 + len);
+	return SENSOR_BUS_OK;
+}
+
+/************************************************************************/
+/* The read and multi-byte flags go in the top bits of the address byte */
+/************************************************************************/
+uint8_t SPIBus::readRegisters(uint8_t reg, uint8_t *data, uint8_t len)
+{
+	uint32_t start = stamp();
+
+	reg |= readFlag;
+	if( len > 1 ) {
+		reg |= multiByteFlag;
+	}
+
+	SPI.beginTransaction(SPISettings(clock, MSBFIRST, SPI_MODE3));
+	digitalWrite(csPin, LOW);
+	SPI.transfer(reg);
+	for(uint8_t i = 0; i < len; i++) {
+		data[i] = SPI.transfer(0);
+	}
+	digitalWrite(csPin, HIGH);
+	SPI.endTransaction();
+	count(SENSOR_BUS_OK, stamp() - start, 1 + len);
+	return SENSOR_BUS_OK;
+}
+
+/************************************************************************/
+/*                                                                      */
+/************************************************************************/
+uint32_t SPIBus::readMicros(uint8_t len)
+{
+	return spiMicros(clock, 1 + len);
+}
+
+uint32_t SPIBus::writeMicros(uint8_t len)
+{
+	return spiMicros(clock, 1 + len);
+}
+
+/**************************************************************************/
+/* Simulated                                                              */
+/**************************************************************************/
+
+SimulatedBus::SimulatedBus(Transport_t transport, uint32_t clk, uint8_t registerMask) : SensorBus(clk)
+{
+	this->transport = transport;
+
+	/* SPI always carries the read and multi-byte flags in the top two bits */
+	this->registerMask = transport == TRANSPORT_SPI ? 0x3F : registerMask;
+	memset(registers, 0, sizeof(registers));
+	pointer = 0;
+	elapsed = 0;
+	transferCount = 0;
+	conversion = NULL;
+	controlReg = 0;
+	convertedAt = 0;
+	early = 0;
+}
+
+void SimulatedBus::begin()
+{
+}
+
+/************************************************************************/
+/* Model a device that converts on command and has no ready flag, such  */
+/* as the BMP085, so that reading its result too soon can be caught     */
+/************************************************************************/
+void SimulatedBus::setConversion(uint8_t controlReg, uint32_t (*conversion)(uint8_t command))
+{
+	this->controlReg = controlReg & registerMask;
+	this->conversion = conversion;
+}
+
+/************************************************************************/
+/* The first byte sets the register pointer, the rest are written       */
+/************************************************************************/
+uint8_t SimulatedBus::write(const uint8_t *data, uint8_t len)
+{
+	if( len == 0 ) {
+		return SENSOR_BUS_OK;
+	}
+	return writeRegisters(data[0], data + 1, len - 1);
+}
+
+/************************************************************************/
+/*                                                                      */
+/************************************************************************/
+uint8_t SimulatedBus::read(uint8_t *data, uint8_t len)
+{
+	return readRegisters(pointer, data, len);
+}
+
+/************************************************************************/
+/*                                                                      */
+/************************************************************************/
+uint8_t SimulatedBus::writeRegisters(uint8_t reg, const uint8_t *data, uint8_t len)
+{
+	pointer = reg & registerMask;
+	if( conversion != NULL && pointer == controlReg && len > 0 ) {
+		convertedAt = micros() + conversion(data[0]);
+	}
+	for(uint8_t i = 0; i < len; i++) {
+		registers[pointer++] = data[i];
+	}
+
+	elapsed += writeMicros(len);
+	transferCount++;
+	count(SENSOR_BUS_OK, writeMicros(len), 1 + len);
+	return SENSOR_BUS_OK;
+}
+
+/************************************************************************/
+/*                                                                      */
+/************************************************************************/
+uint8_t SimulatedBus::readRegisters(uint8_t reg, uint8_t *data, uint8_t len)
+{
+	pointer = reg & registerMask;
+	if( conversion != NULL && (int32_t)(micros() - convertedAt) < 0 ) {
+		early++;
+	}
+	for(uint8_t i = 0; i < len; i++) {
+		data[i] = registers[pointer++];
+	}
+
+	elapsed += readMicros(len);
+	transferCount++;
+	count(SENSOR_BUS_OK, readMicros(len), 1 + len);
+	return SENSOR_BUS_OK;
+}
+
+/************************************************************************/
+/* Same model as the real transport being stood in for                  */
+/************************************************************************/
+uint32_t SimulatedBus::readMicros(uint8_t len)
+{
+	if( transport == TRANSPORT_SPI ) {
+		return spiMicros(clock, 1 + len);
+	}
+	return i2cMicros(clock, (3 + len) * I2C_BITS_PER_BYTE + 3 * I2C_BITS_PER_CONDITION);
+}
+
+uint32_t SimulatedBus::writeMicros(uint8_t len)
+{
+	if( transport == TRANSPORT_SPI ) {
+		return spiMicros(clock, 1 + len);
+	}
+	return i2cMicros(clock, (2 + len) * I2C_BITS_PER_BYTE + 2 * I2C_BITS_PER_CONDITION);
+}
@@ -0,0 +1,292 @@
+/*
+Header file for the Sensor bus transports.
+Copyright (C) 2013-2026 G.Pimblott and contributors
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the version 3 GNU General Public License as
+published by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef SENSORBUS_H_
+#define SENSORBUS_H_
+
+#include "Arduino.h"
+
+/* Uncomment to count the transactions, bytes, errors and time of every */
+/* device on the bus, see SensorBus::getStats(). Costs about 40 bytes   */
+/* of RAM per device and a micros() call either side of each transfer.  */
+//#define SENSOR_BUS_STATS
+
+/* Status codes returned by the bus primitives */
+#define SENSOR_BUS_OK          0
+#define SENSOR_BUS_NACK        1 /**< device did not acknowledge */
+#define SENSOR_BUS_SHORT_READ  2 /**< fewer bytes returned than requested */
+#define SENSOR_BUS_TIMEOUT     3 /**< transaction overran its deadline */
+#define SENSOR_BUS_STUCK       4 /**< a slave is holding SDA low and recovery failed */
+#define SENSOR_BUS_NO_DATA     5 /**< new-data-only read found no new sample, the last one is kept */
+
+/* Register address flags used by the SPI capable chips */
+#define SENSOR_SPI_READ        0x80 /**< ADXL345 R, L3G4200D RW */
+#define SENSOR_SPI_MULTIBYTE   0x40 /**< ADXL345 MB, L3G4200D MS */
+#define SENSOR_I2C_AUTOINC     0x80 /**< L3G4200D sub-address auto increment */
+
+#define SENSOR_I2C_CLOCK       100000L   /**< standard mode */
+#define SENSOR_I2C_CLOCK_FAST  400000L   /**< fast mode */
+#define SENSOR_SPI_CLOCK       5000000L  /**< ADXL345 limit, the L3G4200D runs to 10MHz */
+
+#define SENSOR_I2C_TIMEOUT     5000      /**< per transaction deadline in us */
+#define SENSOR_I2C_RETRIES     2         /**< further attempts after a failed transaction */
+
+#ifdef SENSOR_BUS_STATS
+/* Latency histogram: bin 0 is under SENSOR_BUS_HISTOGRAM_BASE us, each */
+/* following bin doubles, the last bin holds everything slower          */
+#define SENSOR_BUS_HISTOGRAM_BINS  8
+#define SENSOR_BUS_HISTOGRAM_BASE  32
+
+/** Counters for one device, a retried transaction is counted once */
+typedef struct
+{
+	uint32_t transactions;  /**< completed register or raw transfers */
+	uint32_t bytes;         /**< bytes moved after the address, including the register */
+	uint32_t micros;        /**< cumulative time spent in transfers */
+	uint16_t errors;        /**< transactions that failed after any retries */
+	uint16_t retries;       /**< extra attempts made */
+	uint16_t minMicros;
+	uint16_t maxMicros;
+	uint16_t histogram[SENSOR_BUS_HISTOGRAM_BINS];
+} sensor_bus_stats_t;
+#endif
+
+/************************************************************************/
+/* The transport a Sensor uses to reach its registers. One instance is  */
+/* bound to one device (an I2C address or an SPI chip select).          */
+/************************************************************************/
+class SensorBus {
+	public:
+	SensorBus(uint32_t clk)
+	{
+		clock = clk;
+		error = SENSOR_BUS_OK;
+#ifdef SENSOR_BUS_STATS
+		resetStats();
+#endif
+	};
+
+	virtual void begin() = 0;
+
+	virtual uint8_t write(const uint8_t *data, uint8_t len) = 0;
+	virtual uint8_t read(uint8_t *data, uint8_t len) = 0;
+	virtual uint8_t writeRegisters(uint8_t reg, const uint8_t *data, uint8_t len) = 0;
+	virtual uint8_t readRegisters(uint8_t reg, uint8_t *data, uint8_t len) = 0;
+
+	// Modelled time on the wire for a register burst of len bytes
+	virtual uint32_t readMicros(uint8_t len) = 0;
+	virtual uint32_t writeMicros(uint8_t len) = 0;
+
+	virtual uint32_t getClock() { return clock; };
+
+	// First failure since the last clearError(), SENSOR_BUS_OK if none
+	uint8_t getError() { return error; };
+	void clearError() { error = SENSOR_BUS_OK; };
+
+	static uint32_t i2cMicros(uint32_t clock, uint16_t bits);
+	static uint32_t spiMicros(uint32_t clock, uint16_t bytes);
+
+#ifdef SENSOR_BUS_STATS
+	const sensor_bus_stats_t *getStats() { return &stats; };
+	void resetStats();
+#endif
+
+	protected:
+	// Timing hooks for the transports, free when SENSOR_BUS_STATS is off
+#ifdef SENSOR_BUS_STATS
+	uint32_t stamp() { return micros(); };
+	void count(uint8_t result, uint32_t elapsed, uint8_t bytes);
+
+	sensor_bus_stats_t stats;
+#else
+	uint32_t stamp() { return 0; };
+	void count(uint8_t, uint32_t, uint8_t) {};
+#endif
+
+	uint8_t record(uint8_t result)
+	{
+		if( result != SENSOR_BUS_OK && error == SENSOR_BUS_OK ) {
+			error = result;
+		}
+		return result;
+	};
+
+	uint32_t clock;
+	uint8_t error;
+};
+
+/** One device's share of the I2C bus, used to model utilization */
+typedef struct
+{
+	uint8_t  bytes;     /**< bytes in each register burst */
+	uint8_t  reads;     /**< register bursts per sample */
+	uint16_t rate;      /**< samples per second */
+	uint32_t maxClock;  /**< fastest clock the device supports */
+} i2c_schedule_t;
+
+/************************************************************************/
+/* Two wire transport using the Arduino Wire library                    */
+/*                                                                      */
+/* The Wire bus is shared, so it is started once by whichever device    */
+/* begins first and always runs at the requested clock limited by the   */
+/* slowest device that has joined it.                                   */
+/*                                                                      */
+/* Every transaction has a deadline and a bounded number of retries, a  */
+/* slave left holding SDA low is clocked out before the next attempt,   */
+/* so no read can take longer than worstCaseMicros().                   */
+/************************************************************************/
+class I2CBus : public SensorBus {
+	public:
+	I2CBus(uint8_t address, uint8_t autoIncrement = 0) : SensorBus(SENSOR_I2C_CLOCK)
+	{
+		this->address = address;
+		this->autoIncrement = autoIncrement;
+		this->maxClock = SENSOR_I2C_CLOCK_FAST;
+	};
+
+	static void setBusClock(uint32_t clock);
+	static uint32_t getBusClock() { return busClock; };
+	static float utilization(const i2c_schedule_t *schedule, uint8_t count, uint32_t clock);
+	static bool probe(uint8_t address);
+
+	static void setTimeout(uint32_t micros);
+	static uint32_t getTimeout() { return timeout; };
+	static void setRetries(uint8_t count) { retries = count; };
+	static uint8_t getRetries() { return retries; };
+	static uint32_t worstCaseMicros();
+	static bool recover();
+
+	void setMaxClock(uint32_t clock) { maxClock = clock; };
+	uint32_t getMaxClock() { return maxClock; };
+	uint32_t getClock() { return busClock; };
+
+	void begin();
+
+	uint8_t write(const uint8_t *data, uint8_t len);
+	uint8_t read(uint8_t *data, uint8_t len);
+	uint8_t writeRegisters(uint8_t reg, const uint8_t *data, uint8_t len);
+	uint8_t readRegisters(uint8_t reg, uint8_t *data, uint8_t len);
+
+	uint32_t readMicros(uint8_t len);
+	uint32_t writeMicros(uint8_t len);
+
+	uint8_t getAddress() { return address; };
+	void setAddress(uint8_t address) { this->address = address; };
+
+	protected:
+	static void startWire();
+	static void applyClock();
+
+	uint8_t transmit(const uint8_t *prefix, uint8_t prefixLen, const uint8_t *data, uint8_t len);
+	uint8_t receive(uint8_t *data, uint8_t len);
+	bool again(uint8_t *result, uint8_t attempt);
+
+	uint8_t address;
+	uint8_t autoIncrement;
+	uint32_t maxClock;
+
+	static bool started;
+	static uint32_t requestedClock;
+	static uint32_t limitClock;
+	static uint32_t busClock;
+	static uint32_t timeout;
+	static uint8_t retries;
+};
+
+/************************************************************************/
+/* Four wire SPI transport, one chip select per device                  */
+/************************************************************************/
+class SPIBus : public SensorBus {
+	public:
+	SPIBus(uint8_t csPin, uint32_t clk = SENSOR_SPI_CLOCK,
+	       uint8_t readFlag = SENSOR_SPI_READ, uint8_t multiByteFlag = SENSOR_SPI_MULTIBYTE)
+	       : SensorBus(clk)
+	{
+		this->csPin = csPin;
+		this->readFlag = readFlag;
+		this->multiByteFlag = multiByteFlag;
+	};
+
+	void begin();
+
+	uint8_t write(const uint8_t *data, uint8_t len);
+	uint8_t read(uint8_t *data, uint8_t len);
+	uint8_t writeRegisters(uint8_t reg, const uint8_t *data, uint8_t len);
+	uint8_t readRegisters(uint8_t reg, uint8_t *data, uint8_t len);
+
+	uint32_t readMicros(uint8_t len);
+	uint32_t writeMicros(uint8_t len);
+
+	protected:
+	uint8_t csPin;
+	uint8_t readFlag;
+	uint8_t multiByteFlag;
+};
+
+/************************************************************************/
+/* A register file standing in for a real device. Transfers complete    */
+/* immediately and the time the chosen transport would have taken is    */
+/* accumulated, so drivers can be exercised and timed without hardware. */
+/************************************************************************/
+class SimulatedBus : public SensorBus {
+	public:
+	typedef enum
+	{
+		TRANSPORT_I2C,
+		TRANSPORT_SPI
+	} Transport_t;
+
+	// registerMask strips address flags, e.g. 0x7F for the L3G4200D auto increment bit
+	SimulatedBus(Transport_t transport, uint32_t clk, uint8_t registerMask = 0xFF);
+
+	void begin();
+
+	uint8_t write(const uint8_t *data, uint8_t len);
+	uint8_t read(uint8_t *data, uint8_t len);
+	uint8_t writeRegisters(uint8_t reg, const uint8_t *data, uint8_t len);
+	uint8_t readRegisters(uint8_t reg, uint8_t *data, uint8_t len);
+
+	uint32_t readMicros(uint8_t len);
+	uint32_t writeMicros(uint8_t len);
+
+	void poke(uint8_t reg, uint8_t value) { registers[reg] = value; };
+	uint8_t peek(uint8_t reg) { return registers[reg]; };
+
+	// A write to controlReg starts a conversion lasting conversion(value)
+	// us, reads before it has finished are counted by earlyReads()
+	void setConversion(uint8_t controlReg, uint32_t (*conversion)(uint8_t command));
+	uint32_t earlyReads() { return early; };
+
+	uint32_t elapsedMicros() { return elapsed; };
+	uint32_t transfers() { return transferCount; };
+	void resetTiming() { elapsed = 0; transferCount = 0; early = 0; };
+
+	protected:
+	Transport_t transport;
+	uint8_t registers[256];
+	uint8_t registerMask;
+	uint8_t pointer;
+	uint32_t elapsed;
+	uint32_t transferCount;
+	uint32_t (*conversion)(uint8_t command);
+	uint8_t controlReg;
+	uint32_t convertedAt;
+	uint32_t early;
+};
+
+#endif /* SENSORBUS_H_ */
@@ -0,0 +1,173 @@
+/*
+I2C Sensor scanner.
+Copyright (C) 2013-2026 G.Pimblott and contributors
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the version 3 GNU General Public License as
+published by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include "SensorScanner.h"
+#include "L3G4200D.h"
+#include "HMC5883L.h"
+#include "ADXL345.h"
+#include "BMP085.h"
+
+/* Every address one of the supported chips can answer on */
+static const uint8_t candidates[] = {
+	HMC5883L_Address,
+	ADXL345_ADDRESS,
+	ADXL345_ADDRESS_ALT,
+	L3G4200D_ADDRESS,
+	L3G4200D_ADDRESS_ALT,
+	BMP085_ADDRESS
+};
+
+/************************************************************************/
+/*                                                                      */
+/************************************************************************/
+SensorScanner::SensorScanner()
+{
+	count = 0;
+}
+
+/************************************************************************/
+/* Probe every candidate address in a single pass and start a driver    */
+/* for each device identified. Returns the number of sensors found.     */
+/************************************************************************/
+uint8_t SensorScanner::scan()
+{
+	for(uint8_t i = 0; i < sizeof(candidates) && count < SENSOR_REGISTRY_MAX; i++) {
+		uint8_t address = candidates[i];
+
+		if( !I2CBus::probe(address) ) {
+			continue;
+		}
+
+		int32_t type = identify(address);
+		if( type == 0 ) {
+			continue;
+		}
+
+		Sensor *sensor = create(type, address);
+		if( sensor != NULL ) {
+			sensors[count] = sensor;
+			types[count] = type;
+			addresses[count] = address;
+			count++;
+		}
+	}
+
+	return count;
+}
+
+/************************************************************************/
+/* Return the nth sensor of a type (SENSOR_TYPE_xxx) or NULL            */
+/************************************************************************/
+Sensor *SensorScanner::find(int32_t type, uint8_t nth)
+{
+	for(uint8_t i = 0; i < count; i++) {
+		if( types[i] == type && nth-- == 0 ) {
+			return sensors[i];
+		}
+	}
+	return NULL;
+}
+
+/************************************************************************/
+/* Read the ID register of whichever chip can live at the address and   */
+/* return its sensor type, or 0 if it is not one we support             */
+/************************************************************************/
+int32_t SensorScanner::identify(uint8_t address)
+{
+	I2CBus bus(address);
+	uint8_t id[3];
+
+	switch(address) {
+		case HMC5883L_Address:
+			if( bus.readRegisters(IdenificationRegisterA, id, 3) == SENSOR_BUS_OK &&
+			    id[0] == 'H' && id[1] == '4' && id[2] == '3' ) {
+				return SENSOR_TYPE_MAGNETIC_FIELD;
+			}
+			break;
+
+		case ADXL345_ADDRESS:
+		case ADXL345_ADDRESS_ALT:
+			if( bus.readRegisters(ADXL345_DEVID, id, 1) == SENSOR_BUS_OK && id[0] == ADXL345_ID ) {
+				return SENSOR_TYPE_ACCELEROMETER;
+			}
+			break;
+
+		case L3G4200D_ADDRESS:
+		case L3G4200D_ADDRESS_ALT:
+			if( bus.readRegisters(L3G4200D_WHO_AM_I, id, 1) == SENSOR_BUS_OK && id[0] == L3G4200D_ID ) {
+				return SENSOR_TYPE_GYROSCOPE;
+			}
+			break;
+
+		case BMP085_ADDRESS:
+			if( bus.readRegisters(BMP085_REGISTER_CHIPID, id, 1) == SENSOR_BUS_OK && id[0] == BMP085_CHIPID ) {
+				return SENSOR_TYPE_PRESSURE;
+			}
+			break;
+	}
+
+	return 0;
+}
+
+/************************************************************************/
+/* Create and start the driver with its default settings, the I2C       */
+/* address doubles as the sensor id                                     */
+/************************************************************************/
+Sensor *SensorScanner::create(int32_t type, uint8_t address)
+{
+	switch(type) {
+		case SENSOR_TYPE_MAGNETIC_FIELD: {
+			HMC5883L *compass = new HMC5883L(address);
+			if( compass->begin() ) {
+				compass->SetScale(1.3f);
+				compass->SetMeasurementMode(Measurement_Continuous);
+				return compass;
+			}
+			delete compass;
+			break;
+		}
+
+		case SENSOR_TYPE_ACCELEROMETER: {
+			ADXL345 *accel = new ADXL345(address, address);
+			if( accel->begin() ) {
+				return accel;
+			}
+			delete accel;
+			break;
+		}
+
+		case SENSOR_TYPE_GYROSCOPE: {
+			L3G4200D *gyro = new L3G4200D(address, address);
+			if( gyro->setup(L3G4200D::RANGE_250DPS) ) {
+				return gyro;
+			}
+			delete gyro;
+			break;
+		}
+
+		case SENSOR_TYPE_PRESSURE: {
+			BMP085 *bmp = new BMP085(address);
+			if( bmp->begin() ) {
+				return bmp;
+			}
+			delete bmp;
+			break;
+		}
+	}
+
+	return NULL;
+}
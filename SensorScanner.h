@@ -0,0 +1,58 @@
+/*
+Header file for the I2C Sensor scanner.
+Copyright (C) 2013-2026 G.Pimblott and contributors
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the version 3 GNU General Public License as
+published by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef SENSORSCANNER_H_
+#define SENSORSCANNER_H_
+
+#include "Sensor.h"
+
+#define SENSOR_REGISTRY_MAX 8
+
+/************************************************************************/
+/* Finds the supported sensors on the I2C bus at run time.              */
+/*                                                                      */
+/* Each candidate address is probed once, anything that acknowledges    */
+/* is identified from its ID register(s), and a driver is created and   */
+/* started for it. Drivers are allocated once at boot and live for the  */
+/* rest of the program.                                                 */
+/************************************************************************/
+class SensorScanner {
+	public:
+	SensorScanner();
+
+	uint8_t scan();
+
+	uint8_t size() { return count; };
+	Sensor *get(uint8_t index) { return index < count ? sensors[index] : NULL; };
+	Sensor **getAll() { return sensors; };
+	int32_t getType(uint8_t index) { return index < count ? types[index] : 0; };
+	uint8_t getAddress(uint8_t index) { return index < count ? addresses[index] : 0; };
+	Sensor *find(int32_t type, uint8_t nth = 0);
+
+	static int32_t identify(uint8_t address);
+
+	protected:
+	Sensor *create(int32_t type, uint8_t address);
+
+	Sensor *sensors[SENSOR_REGISTRY_MAX];
+	int32_t types[SENSOR_REGISTRY_MAX];
+	uint8_t addresses[SENSOR_REGISTRY_MAX];
+	uint8_t count;
+};
+
+#endif /* SENSORSCANNER_H_ */
@@ -0,0 +1,117 @@
+/*
+Sample latency and jitter trace.
+Copyright (C) 2013-2026 G.Pimblott and contributors
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the version 3 GNU General Public License as
+published by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include "SensorTrace.h"
+
+/************************************************************************/
+/* periodMicros is the intended time between samples                    */
+/************************************************************************/
+SensorTrace::SensorTrace(uint32_t periodMicros)
+{
+	period = periodMicros;
+	reset();
+}
+
+/************************************************************************/
+/*                                                                      */
+/************************************************************************/
+void SensorTrace::reset()
+{
+	previous = 0;
+	count = 0;
+	latencyMax = 0;
+	jitterMax = 0;
+	memset(latency, 0, sizeof(latency));
+	memset(jitter, 0, sizeof(jitter));
+}
+
+/************************************************************************/
+/* Record a sample that has just been read. Jitter is the difference    */
+/* between the time since the previous sample and the period.           */
+/************************************************************************/
+void SensorTrace::record(uint32_t latencyMicros)
+{
+	uint32_t now = micros();
+
+	add(latency, latencyMicros);
+	if( latencyMicros > latencyMax ) {
+		latencyMax = latencyMicros;
+	}
+
+	if( count > 0 ) {
+		uint32_t interval = now - previous;
+		uint32_t error = interval > period ? interval - period : period - interval;
+
+		add(jitter, error);
+		if( error > jitterMax ) {
+			jitterMax = error;
+		}
+	}
+
+	previous = now;
+	count++;
+}
+
+/************************************************************************/
+/*                                                                      */
+/************************************************************************/
+void SensorTrace::add(uint16_t *histogram, uint32_t micros)
+{
+	uint8_t bin = 0;
+
+	for(uint32_t limit = SENSOR_TRACE_BASE;
+	    bin < SENSOR_TRACE_BINS - 1 && micros >= limit; limit <<= 1) {
+		bin++;
+	}
+	if( histogram[bin] < 0xFFFF ) {
+		histogram[bin]++;
+	}
+}
+
+/************************************************************************/
+/* Print both histograms, each bin labelled with its upper bound in us  */
+/************************************************************************/
+void SensorTrace::dump(Print *out)
+{
+	out->print("Samples: ");
+	out->println(count);
+	out->print("Latency max ");
+	out->print(latencyMax);
+	out->print(" us:");
+	print(out, latency);
+	out->print("Jitter max ");
+	out->print(jitterMax);
+	out->print(" us:");
+	print(out, jitter);
+}
+
+void SensorTrace::print(Print *out, const uint16_t *histogram)
+{
+	uint32_t limit = SENSOR_TRACE_BASE;
+
+	for(uint8_t i = 0; i < SENSOR_TRACE_BINS; i++, limit <<= 1) {
+		out->print(" <");
+		if( i == SENSOR_TRACE_BINS - 1 ) {
+			out->print("inf");
+		} else {
+			out->print(limit);
+		}
+		out->print("=");
+		out->print(histogram[i]);
+	}
+	out->println();
+}
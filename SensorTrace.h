@@ -0,0 +1,68 @@
+/*
+Header file for the sample latency and jitter trace.
+Copyright (C) 2013-2026 G.Pimblott and contributors
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the version 3 GNU General Public License as
+published by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef SENSORTRACE_H_
+#define SENSORTRACE_H_
+
+#include "Arduino.h"
+#include "Sensor.h"
+
+/* Histogram bin 0 is under SENSOR_TRACE_BASE us, each following bin    */
+/* doubles and the last holds everything slower (16us .. 16ms)          */
+#define SENSOR_TRACE_BINS 12
+#define SENSOR_TRACE_BASE 16
+
+/************************************************************************/
+/* Fixed size record of how old each sample is when it is read and how  */
+/* far the time between samples strays from the intended period.        */
+/*                                                                      */
+/* One trace per stream of samples, e.g. one per sensor and one for     */
+/* loop() itself. Nothing is allocated and the counters saturate, so a  */
+/* trace can be left running indefinitely and dumped when wanted.       */
+/************************************************************************/
+class SensorTrace {
+	public:
+	SensorTrace(uint32_t periodMicros);
+
+	void record(uint32_t latencyMicros);
+	void record(const sensors_event_t *event) { record((uint32_t)event->latency); };
+	void tick() { record((uint32_t)0); };
+
+	void reset();
+	void dump(Print *out);
+
+	uint32_t samples() { return count; };
+	uint32_t maxLatency() { return latencyMax; };
+	uint32_t maxJitter() { return jitterMax; };
+	const uint16_t *latencyHistogram() { return latency; };
+	const uint16_t *jitterHistogram() { return jitter; };
+
+	private:
+	static void add(uint16_t *histogram, uint32_t micros);
+	static void print(Print *out, const uint16_t *histogram);
+
+	uint32_t period;
+	uint32_t previous;
+	uint32_t count;
+	uint32_t latencyMax;
+	uint32_t jitterMax;
+	uint16_t latency[SENSOR_TRACE_BINS];
+	uint16_t jitter[SENSOR_TRACE_BINS];
+};
+
+#endif /* SENSORTRACE_H_ */
@@ -0,0 +1,279 @@
+/*
+Vertical Kalman filter.
+Copyright (C) 2013-2026 G.Pimblott and contributors
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the version 3 GNU General Public License as
+published by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include "VerticalKalman.h"
+
+/* Iterations allowed for the fixed point gains to settle */
+#define VERTICAL_KALMAN_SETTLE 200
+
+/************************************************************************/
+/* Defaults to 100Hz, a correction every 4th sample, 0.35m/s^2 of       */
+/* accelerometer noise, 0.5m of barometer noise and 0.01m/s^2 per       */
+/* root second of bias drift                                            */
+/************************************************************************/
+VerticalKalman::VerticalKalman()
+{
+	configure(10000, 4, 0.35F, 0.5F, 0.01F);
+}
+
+/************************************************************************/
+/* periodMicros is the accelerometer period, predictsPerCorrect how     */
+/* many predict() calls there are for each correct(). Noise figures are */
+/* standard deviations: accelNoise in m/s^2 per sample, baroNoise in m  */
+/* and biasDrift in m/s^2 per root second.                              */
+/************************************************************************/
+void VerticalKalman::configure(uint32_t periodMicros, uint8_t predictsPerCorrect,
+                               float accelNoise, float baroNoise, float biasDrift)
+{
+	float seconds = periodMicros * 1e-6F;
+	float variance = accelNoise * accelNoise;
+	float drift = biasDrift * biasDrift * seconds;
+	float noise = baroNoise * baroNoise;
+
+	period = periodMicros;
+
+#ifdef VERTICAL_KALMAN_FIXED
+	// Run the covariance until the gains stop changing and keep those
+	float p[3][3] = { { noise, 0, 0 }, { 0, 1, 0 }, { 0, 0, 1 } };
+	float k[3] = { 0, 0, 0 };
+	float previous = -1;
+
+	if( predictsPerCorrect == 0 ) {
+		predictsPerCorrect = 1;
+	}
+	for(uint8_t i = 0; i < VERTICAL_KALMAN_SETTLE; i++) {
+		for(uint8_t j = 0; j < predictsPerCorrect; j++) {
+			predictCovariance(p, seconds, variance, drift);
+		}
+		correctCovariance(p, noise, k);
+		if( fabs(k[0] - previous) < 1e-6F ) {
+			break;
+		}
+		previous = k[0];
+	}
+
+	dtQ16 = (uint16_t)constrain(seconds * 65536.0F + 0.5F, 1.0F, 65535.0F);
+	gainH = (uint16_t)constrain(k[0] * 65536.0F + 0.5F, 0.0F, 65535.0F);
+	gainV = (uint16_t)constrain(k[1] * 4096.0F + 0.5F, 0.0F, 65535.0F);
+	gainB = (uint16_t)constrain(-k[2] * 65536.0F + 0.5F, 0.0F, 65535.0F);
+#else
+	(void)predictsPerCorrect;
+	dt = seconds;
+	qa = variance;
+	qb = drift;
+	r = noise;
+#endif
+	reset();
+}
+
+/************************************************************************/
+/* Forget the state, the next correct() starts the filter again         */
+/************************************************************************/
+void VerticalKalman::reset()
+{
+	valid = false;
+#ifdef VERTICAL_KALMAN_FIXED
+	origin = 0;
+	h = 0;
+	v = 0;
+	b = 0;
+	a = 0;
+#else
+	memset(x, 0, sizeof(x));
+	memset(p, 0, sizeof(p));
+	a = 0;
+#endif
+}
+
+/************************************************************************/
+/* Advance by one accelerometer period. accelMg is the specific force   */
+/* along the vertical, so 1000 with the board still.                    */
+/************************************************************************/
+void VerticalKalman::predict(int16_t accelMg)
+{
+	if( !valid ) {
+		return;
+	}
+
+#ifdef VERTICAL_KALMAN_FIXED
+	// 9807um/s^2 per mg, taking gravity off first keeps rest exactly 0
+	a = ((int32_t)accelMg - 1000) * 9807L - b;
+
+	int32_t dv = mulShift(a, dtQ16, 16);
+	h += mulShift(v, dtQ16, 16) + (mulShift(dv, dtQ16, 16) >> 1);
+	v += dv;
+#else
+	a = (accelMg - 1000) * (SENSORS_GRAVITY_STANDARD / 1000.0F) - x[2];
+	x[0] += x[1] * dt + 0.5F * a * dt * dt;
+	x[1] += a * dt;
+	predictCovariance(p, dt, qa, qb);
+#endif
+}
+
+/************************************************************************/
+/* Blend in a barometric altitude. The first one starts the filter.     */
+/************************************************************************/
+void VerticalKalman::correct(int32_t altitudeMm)
+{
+#ifdef VERTICAL_KALMAN_FIXED
+	if( !valid ) {
+		origin = altitudeMm;
+		h = v = b = a = 0;
+		valid = true;
+		return;
+	}
+
+	// Keep the innovation inside the +/-2km the state can represent
+	int32_t above = constrain(altitudeMm - origin, -2000000L, 2000000L);
+	int32_t e = above * 1000L - h;
+
+	h += mulShift(e, gainH, 16);
+	v += mulShift(e, gainV, 12);
+	b -= mulShift(e, gainB, 16);
+#else
+	float z = altitudeMm * 1e-3F;
+
+	if( !valid ) {
+		memset(p, 0, sizeof(p));
+		x[0] = z;
+		x[1] = x[2] = 0;
+		p[0][0] = r;
+		p[1][1] = 1;
+		p[2][2] = 1;
+		valid = true;
+		return;
+	}
+
+	float k[3];
+	float e = z - x[0];
+	correctCovariance(p, r, k);
+	for(uint8_t i = 0; i < 3; i++) {
+		x[i] += k[i] * e;
+	}
+#endif
+}
+
+/************************************************************************/
+/* Results in SI units                                                  */
+/************************************************************************/
+float VerticalKalman::altitude()
+{
+#ifdef VERTICAL_KALMAN_FIXED
+	return origin * 1e-3F + h * 1e-6F;
+#else
+	return x[0];
+#endif
+}
+
+float VerticalKalman::velocity()
+{
+#ifdef VERTICAL_KALMAN_FIXED
+	return v * 1e-6F;
+#else
+	return x[1];
+#endif
+}
+
+float VerticalKalman::acceleration()
+{
+#ifdef VERTICAL_KALMAN_FIXED
+	return a * 1e-6F;
+#else
+	return a;
+#endif
+}
+
+float VerticalKalman::bias()
+{
+#ifdef VERTICAL_KALMAN_FIXED
+	return b * 1e-6F;
+#else
+	return x[2];
+#endif
+}
+
+/************************************************************************/
+/* The estimate as a SENSOR_TYPE_LINEAR_ACCELERATION event: x holds the */
+/* altitude in m, y the vertical velocity in m/s and z the vertical     */
+/* acceleration less gravity and bias in m/s^2                          */
+/************************************************************************/
+void VerticalKalman::getEvent(sensors_event_t *event)
+{
+	memset(event, 0, sizeof(sensors_event_t));
+
+	event->version   = sizeof(sensors_event_t);
+	event->type      = SENSOR_TYPE_LINEAR_ACCELERATION;
+	event->timestamp = millis();
+	event->acceleration.x = altitude();
+	event->acceleration.y = velocity();
+	event->acceleration.z = acceleration();
+}
+
+/************************************************************************/
+/* P = F P F' + Q for one period, F and the noise as in the header      */
+/************************************************************************/
+void VerticalKalman::predictCovariance(float p[3][3], float dt, float qa, float qb)
+{
+	float f[3][3] = { { 1, dt, -0.5F * dt * dt }, { 0, 1, -dt }, { 0, 0, 1 } };
+	float g[3] = { 0.5F * dt * dt, dt, 0 };
+	float fp[3][3];
+
+	for(uint8_t i = 0; i < 3; i++) {
+		for(uint8_t j = 0; j < 3; j++) {
+			fp[i][j] = f[i][0] * p[0][j] + f[i][1] * p[1][j] + f[i][2] * p[2][j];
+		}
+	}
+	for(uint8_t i = 0; i < 3; i++) {
+		for(uint8_t j = 0; j < 3; j++) {
+			p[i][j] = fp[i][0] * f[j][0] + fp[i][1] * f[j][1] + fp[i][2] * f[j][2]
+			        + g[i] * g[j] * qa;
+		}
+	}
+	p[2][2] += qb;
+}
+
+/************************************************************************/
+/* Gain for an altitude measurement with variance r and P = (I - KH) P  */
+/************************************************************************/
+void VerticalKalman::correctCovariance(float p[3][3], float r, float k[3])
+{
+	float s = p[0][0] + r;
+	float row[3] = { p[0][0], p[0][1], p[0][2] };
+
+	for(uint8_t i = 0; i < 3; i++) {
+		k[i] = p[i][0] / s;
+	}
+	for(uint8_t i = 0; i < 3; i++) {
+		for(uint8_t j = 0; j < 3; j++) {
+			p[i][j] -= k[i] * row[j];
+		}
+	}
+}
+
+#ifdef VERTICAL_KALMAN_FIXED
+/************************************************************************/
+/* (a * q) >> shift for shift <= 16 without a 64-bit multiply: the low  */
+/* half of a times q always fits 32 bits unsigned                       */
+/************************************************************************/
+int32_t VerticalKalman::mulShift(int32_t a, uint16_t q, uint8_t shift)
+{
+	int32_t high = a >> 16;
+	uint32_t low = (uint32_t)a & 0xFFFF;
+
+	return high * q * (1L << (16 - shift)) + (int32_t)((low * q) >> shift);
+}
+#endif
@@ -0,0 +1,97 @@
+/*
+Header file for the vertical Kalman filter.
+Copyright (C) 2013-2026 G.Pimblott and contributors
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the version 3 GNU General Public License as
+published by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef VERTICALKALMAN_H_
+#define VERTICALKALMAN_H_
+
+#include "Arduino.h"
+#include "Sensor.h"
+
+/* On AVR the filter runs in constant-gain fixed point. Uncomment the   */
+/* first to run the full floating point filter there as well, as on     */
+/* other hosts, or the second to run the fixed point form everywhere.   */
+//#define VERTICAL_KALMAN_FLOAT
+//#define VERTICAL_KALMAN_FIXED
+
+#if defined(__AVR__) && !defined(VERTICAL_KALMAN_FLOAT) && !defined(VERTICAL_KALMAN_FIXED)
+#define VERTICAL_KALMAN_FIXED
+#endif
+
+/************************************************************************/
+/* Altitude, vertical velocity and accelerometer bias from a barometer  */
+/* and an accelerometer.                                                */
+/*                                                                      */
+/* predict() runs at the accelerometer rate with the vertical specific  */
+/* force in mg, 1000 at rest. correct() runs whenever a barometric      */
+/* altitude arrives. The state is                                       */
+/*   h' = h + v dt + (a - b) dt^2 / 2                                   */
+/*   v' = v + (a - b) dt                                                */
+/*   b' = b                                                             */
+/*                                                                      */
+/* The fixed point form uses the steady state gains for the configured  */
+/* rates, worked out once in configure(). Its state is in micrometres   */
+/* relative to the first barometer reading, so it covers +/-2km of      */
+/* climb. The floating point form carries the full covariance.          */
+/************************************************************************/
+class VerticalKalman {
+	public:
+	VerticalKalman();
+
+	void configure(uint32_t periodMicros, uint8_t predictsPerCorrect,
+	               float accelNoise, float baroNoise, float biasDrift);
+	void reset();
+
+	void predict(int16_t accelMg);
+	void correct(int32_t altitudeMm);
+
+	bool isValid() { return valid; };
+	float altitude();
+	float velocity();
+	float acceleration();
+	float bias();
+	void getEvent(sensors_event_t *event);
+
+	private:
+	static void predictCovariance(float p[3][3], float dt, float qa, float qb);
+	static void correctCovariance(float p[3][3], float r, float k[3]);
+
+	uint32_t period;
+	bool valid;
+
+#ifdef VERTICAL_KALMAN_FIXED
+	static int32_t mulShift(int32_t a, uint16_t q, uint8_t shift);
+
+	uint16_t dtQ16;        /* period in seconds, Q16 */
+	uint16_t gainH;        /* steady state gains, Q16, Q12 and Q16 */
+	uint16_t gainV;
+	uint16_t gainB;
+	int32_t origin;        /* mm, first barometer reading */
+	int32_t h;             /* um above origin */
+	int32_t v;             /* um/s */
+	int32_t b;             /* um/s^2 */
+	int32_t a;             /* um/s^2, last bias corrected acceleration */
+#else
+	float dt;
+	float qa, qb, r;
+	float x[3];
+	float p[3][3];
+	float a;
+#endif
+};
+
+#endif /* VERTICALKALMAN_H_ */
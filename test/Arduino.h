@@ -0,0 +1,22 @@
+/*
+Host stand-in for the Arduino core, just enough for the filter classes
+to build with the tests in this directory. Not part of the sketch.
+*/
+#ifndef ARDUINO_H_
+#define ARDUINO_H_
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define PI 3.1415926535897932384626433832795
+#define constrain(amt,low,high) ((amt)<(low)?(low):((amt)>(high)?(high):(amt)))
+
+static inline unsigned long millis() { return 0; }
+static inline unsigned long micros() { return 0; }
+
+#endif /* ARDUINO_H_ */
@@ -0,0 +1,117 @@
+/*
+CicDecimatorTest.cpp - Host test of CicDecimator
+Copyright (C) 2013-2026 G.Pimblott and contributors
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/************************************************************************/
+/* Measures the passband gain of the decimator with sines up to a       */
+/* quarter of the output rate, checks the compensated filter is flat to */
+/* within 3% there for ratios of 4 and up, as the header says, and that */
+/* a step settles to the input as soon as the first output is released. */
+/* From the repository root:                                            */
+/*   g++ -I test -I . test/CicDecimatorTest.cpp CicDecimator.cpp \      */
+/*       -o cic && ./cic                                                */
+/* Exits non-zero on failure.                                           */
+/************************************************************************/
+#include <stdio.h>
+
+#include "CicDecimator.h"
+
+#define AMPLITUDE  10000
+#define OUTPUTS    2000    /* outputs measured for each frequency */
+#define STEPS      10      /* frequencies from 0 to a quarter of the output rate */
+
+static int failures = 0;
+
+/* Gain at cycles per output sample, fitting a sine of that frequency */
+static float gain(uint8_t ratio, uint8_t order, bool compensate, float frequency)
+{
+	CicDecimator cic(ratio, order, compensate);
+	int16_t in[3], out[3];
+	double sine = 0, cosine = 0;
+	long n = 0;
+	uint16_t k = 0;
+
+	while( k < OUTPUTS ) {
+		float phase = 2 * PI * frequency * n / ratio;
+
+		in[0] = in[1] = in[2] = (int16_t)lround(AMPLITUDE * sin(phase));
+		n++;
+		if( cic.push(in, out) ) {
+			/* The filter delay only shifts the phase, not the fit */
+			double t = 2 * PI * frequency * k;
+			sine += out[0] * sin(t);
+			cosine += out[0] * cos(t);
+			k++;
+		}
+	}
+	return 2 * sqrt(sine * sine + cosine * cosine) / OUTPUTS / AMPLITUDE;
+}
+
+static void passband(uint8_t ratio, uint8_t order)
+{
+	float worst = 0, droop = 1;
+
+	for(uint8_t i = 1; i <= STEPS; i++) {
+		float frequency = 0.25F * i / STEPS;
+		float compensated = gain(ratio, order, true, frequency);
+
+		worst = fmax(worst, fabs(compensated - 1));
+		droop = fmin(droop, gain(ratio, order, false, frequency));
+	}
+
+	/* Ratios below 4 droop more than one tap can lift, only report them */
+	bool ok = worst <= 0.03F || ratio < 4;
+	printf("ratio %2u order %u: worst %.4f compensated, %.4f without  %s\n",
+	       ratio, order, worst, 1 - droop, ratio < 4 ? "not checked" : ok ? "ok" : "FAIL");
+	if( !ok ) {
+		failures++;
+	}
+}
+
+static void step(uint8_t ratio, uint8_t order, bool compensate)
+{
+	CicDecimator cic(ratio, order, compensate);
+	int16_t in[3] = { 1000, -1000, 0 }, out[3];
+	bool ok = true;
+
+	for(uint16_t n = 0; n < 20 * ratio; n++) {
+		if( cic.push(in, out) ) {
+			ok = ok && out[0] == 1000 && out[1] == -1000 && out[2] == 0;
+		}
+	}
+	printf("ratio %2u order %u %-12s step  %s\n", ratio, order,
+	       compensate ? "compensated" : "plain", ok ? "ok" : "FAIL");
+	if( !ok ) {
+		failures++;
+	}
+}
+
+int main()
+{
+	uint8_t ratios[] = { 2, 4, 8, 32 };
+
+	for(uint8_t r = 0; r < sizeof(ratios); r++) {
+		for(uint8_t order = 1; order <= CIC_MAX_ORDER; order++) {
+			passband(ratios[r], order);
+			step(ratios[r], order, false);
+			step(ratios[r], order, true);
+		}
+	}
+
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,136 @@
+/*
+VerticalKalmanTest.cpp - Host test of VerticalKalman
+Copyright (C) 2013-2026 G.Pimblott and contributors
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/************************************************************************/
+/* Runs the fixed point and floating point filters side by side on the  */
+/* same synthetic climb and checks they agree with each other and with  */
+/* the true trajectory. From the repository root:                       */
+/*   g++ -I test -I . test/VerticalKalmanTest.cpp -o vk && ./vk         */
+/* Exits non-zero on failure.                                           */
+/************************************************************************/
+#include <stdio.h>
+
+#include "Arduino.h"
+#include "Sensor.h"
+
+/* Both forms in one program, each in its own namespace */
+namespace fixedForm {
+#define VERTICAL_KALMAN_FIXED
+#include "VerticalKalman.cpp"
+#undef VERTICAL_KALMAN_FIXED
+#undef VERTICALKALMAN_H_
+}
+
+namespace floatForm {
+#define VERTICAL_KALMAN_FLOAT
+#include "VerticalKalman.cpp"
+}
+
+#define RATE_HZ       100     /* accelerometer rate */
+#define PER_CORRECT   4       /* barometer at 25Hz */
+#define BIAS_MG       20      /* accelerometer bias the filter must learn */
+#define SECONDS       60
+
+/* Repeatable noise, uniform in -1 .. 1 */
+static float noise()
+{
+	static uint32_t state = 12345;
+
+	state = state * 1103515245UL + 12345UL;
+	return ((state >> 8) & 0xFFFF) / 32768.0F - 1.0F;
+}
+
+/* Rest, climb at 2m/s, rest, with 1m/s^2 ramps between */
+static float trueAcceleration(float t)
+{
+	if( t >= 10 && t < 12 ) {
+		return 1.0F;
+	}
+	if( t >= 30 && t < 32 ) {
+		return -1.0F;
+	}
+	return 0;
+}
+
+static int failures = 0;
+
+static void check(const char *what, float value, float limit)
+{
+	bool ok = fabs(value) <= limit;
+
+	printf("%-36s %9.3f  (limit %.3f) %s\n", what, value, limit, ok ? "ok" : "FAIL");
+	if( !ok ) {
+		failures++;
+	}
+}
+
+int main()
+{
+	fixedForm::VerticalKalman fixed;
+	floatForm::VerticalKalman floating;
+	float dt = 1.0F / RATE_HZ;
+	float h = 100.0F, v = 0;
+	float worstH = 0, worstV = 0;
+	float worstFixedH = 0, worstFloatH = 0;
+
+	fixed.configure(1000000L / RATE_HZ, PER_CORRECT, 0.35F, 0.5F, 0.01F);
+	floating.configure(1000000L / RATE_HZ, PER_CORRECT, 0.35F, 0.5F, 0.01F);
+
+	for(long n = 0; n < (long)SECONDS * RATE_HZ; n++) {
+		float t = n * dt;
+		float a = trueAcceleration(t);
+
+		h += v * dt + 0.5F * a * dt * dt;
+		v += a * dt;
+
+		int16_t mg = (int16_t)lround(1000 + a * 1000 / SENSORS_GRAVITY_STANDARD
+		                             + BIAS_MG + 10 * noise());
+		fixed.predict(mg);
+		floating.predict(mg);
+
+		if( n % PER_CORRECT == 0 ) {
+			int32_t mm = (int32_t)lround((h + 0.3F * noise()) * 1000);
+			fixed.correct(mm);
+			floating.correct(mm);
+		}
+
+		// The float form starts from a wide covariance while the fixed
+		// form has its steady state gains from the start, so judge them
+		// from the climb on, once both have settled
+		if( t >= 10 ) {
+			worstH = fmax(worstH, fabs(fixed.altitude() - floating.altitude()));
+			worstV = fmax(worstV, fabs(fixed.velocity() - floating.velocity()));
+			worstFixedH = fmax(worstFixedH, fabs(fixed.altitude() - h));
+			worstFloatH = fmax(worstFloatH, fabs(floating.altitude() - h));
+		}
+	}
+
+	float biasMs2 = BIAS_MG * SENSORS_GRAVITY_STANDARD / 1000;
+
+	check("fixed - float altitude, worst (m)", worstH, 0.1F);
+	check("fixed - float velocity, worst (m/s)", worstV, 0.1F);
+	check("fixed altitude error, worst (m)", worstFixedH, 0.5F);
+	check("float altitude error, worst (m)", worstFloatH, 0.5F);
+	check("fixed velocity error, end (m/s)", fixed.velocity() - v, 0.1F);
+	check("float velocity error, end (m/s)", floating.velocity() - v, 0.1F);
+	check("fixed bias error, end (m/s^2)", fixed.bias() - biasMs2, 0.05F);
+	check("float bias error, end (m/s^2)", floating.bias() - biasMs2, 0.05F);
+
+	return failures ? 1 : 0;
+}